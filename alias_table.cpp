@@ -0,0 +1,74 @@
+// alias_table.cpp
+// Implementing the alias table construction declared in alias_table.hpp
+
+#include "alias_table.hpp"
+
+
+using namespace std;
+
+
+// Build an alias table with Vose's method (Vose 1991, "A Linear Algorithm for Generating Random
+// Numbers with a Given Distribution").  Each column starts with probability n*p_i; columns below 1
+// are topped up from a column above 1, which becomes their alias.
+AliasTable::AliasTable(const vector<double>& probs){
+
+    int n = probs.size();
+    entries.resize(n);
+
+    // Normalize in case the probabilities in the file don't sum to exactly one
+    double total = 0;
+    for(int i = 0; i < n; i++){
+        total += probs[i];
+    }
+    // A distribution with no mass (e.g. an empty row) always draws the first outcome
+    if( total <= 0 ){
+        for(int i = 0; i < n; i++){
+            entries[i].threshold = 0;
+            entries[i].alias = 0;
+        }
+        return;
+    }
+
+    // Split columns into those below and above the average probability
+    vector<double> scaled(n);
+    vector<int> small;
+    vector<int> large;
+    for(int i = 0; i < n; i++){
+        scaled[i] = probs[i] * n / total;
+        if( scaled[i] < 1 ){
+            small.push_back(i);
+        } else {
+            large.push_back(i);
+        }
+    }
+
+    // Pair each small column with a large one, moving the large column's leftover mass along
+    while( !small.empty() && !large.empty() ){
+        int s = small.back();
+        small.pop_back();
+        int l = large.back();
+        large.pop_back();
+
+        entries[s].threshold = scaled[s];
+        entries[s].alias = l;
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1;
+        if( scaled[l] < 1 ){
+            small.push_back(l);
+        } else {
+            large.push_back(l);
+        }
+    }
+
+    // Whatever remains is (up to rounding error) exactly full
+    while( !large.empty() ){
+        entries[large.back()].threshold = 1;
+        entries[large.back()].alias = large.back();
+        large.pop_back();
+    }
+    while( !small.empty() ){
+        entries[small.back()].threshold = 1;
+        entries[small.back()].alias = small.back();
+        small.pop_back();
+    }
+}
@@ -0,0 +1,52 @@
+// alias_table.hpp
+// Walker alias tables for drawing from discrete distributions in constant time
+// Used for the number of other bidders and the bidder types in simulated auctions, which would
+// otherwise need a linear scan over the cumulative distribution for every draw.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef ALIAS_TABLE_INCLUDED
+#define ALIAS_TABLE_INCLUDED
+
+#include <vector>
+
+
+// One column of the alias table: keep the column's own outcome with probability threshold,
+// otherwise return the alias
+typedef struct {
+    double threshold;
+    int alias;
+} AliasEntry;
+
+// Alias table for a distribution over {0, ..., n - 1}
+class AliasTable {
+
+public:
+
+    // Build the table from (not necessarily normalized) probabilities using Vose's method
+    AliasTable(const std::vector<double>& probs);
+
+    // Draw an outcome from a single uniform on [0, 1): the integer part of u*n picks the column
+    // and the fractional part decides between the column and its alias.  Defined here so that it
+    // is inlined into the simulation loop.
+    int draw(double u) const {
+        double scaled = u * entries.size();
+        int column = (int)scaled;
+        if( column >= (int)entries.size() ){
+            column = entries.size() - 1;
+        }
+        return( (scaled - column < entries[column].threshold) ? column : entries[column].alias );
+    }
+
+    // Number of outcomes
+    int size() const {
+        return( entries.size() );
+    }
+
+private:
+
+    std::vector<AliasEntry> entries;
+};
+
+
+// End header guard with endif statement
+#endif
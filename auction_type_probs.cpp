@@ -0,0 +1,383 @@
+// auction_type_probs.cpp
+// Implementing the unobserved auction type estimation declared in auction_type_probs.hpp
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "auction_type_probs.hpp"
+#include "weighted_kde.hpp"
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+// Auctions in each task of the update
+static const size_t updateTaskAuctions = 16384;
+
+
+// Run task(t) for t = 0, ..., numTasks - 1 on numThreads threads, each taking the next task from a
+// shared counter
+template <typename Task>
+static void runTasks(size_t numTasks, int numThreads, const Task& task){
+    atomic<size_t> nextTask(0);
+    auto worker = [&](){
+        for(size_t t = nextTask.fetch_add(1); t < numTasks; t = nextTask.fetch_add(1)){
+            task(t);
+        }
+    };
+    vector<thread> threads;
+    for(size_t i = 1; i < min((size_t)numThreads, numTasks); i++){
+        threads.push_back( thread(worker) );
+    }
+    worker();
+    for(size_t i = 0; i < threads.size(); i++){
+        threads[i].join();
+    }
+}
+
+
+// Group the bids by auction: a stable sort of the rows by auction ID keeps each auction's bids in
+// file order
+AuctionIndex indexAuctions(const vector<Bid>& bids){
+
+    AuctionIndex index;
+    index.bidOrder.resize(bids.size());
+    for(size_t i = 0; i < bids.size(); i++){
+        index.bidOrder[i] = i;
+    }
+    stable_sort(index.bidOrder.begin(), index.bidOrder.end(), [&](size_t a, size_t b){
+        return( bids[a].auctionID < bids[b].auctionID );
+    });
+
+    for(size_t n = 0; n < bids.size(); n++){
+        if( (n == 0) || (bids[index.bidOrder[n]].auctionID != bids[index.bidOrder[n - 1]].auctionID) ){
+            index.auctionStart.push_back(n);
+        }
+    }
+    index.auctionStart.push_back(bids.size());
+    return( index );
+}
+
+
+// Quantile p of sorted values, interpolated as MATLAB's quantile() does: the i-th smallest of n
+// values is the (i - 0.5)/n quantile
+static double matlabQuantile(const vector<double>& sorted, double p){
+    size_t n = sorted.size();
+    double position = n*p + 0.5;
+    if( position <= 1 ){
+        return( sorted[0] );
+    }
+    if( position >= n ){
+        return( sorted[n - 1] );
+    }
+    size_t below = (size_t)position;
+    return( sorted[below - 1] + (position - below)*(sorted[below] - sorted[below - 1]) );
+}
+
+// Start each bid's auction at .75 on the type whose range of average bids it falls in and spread the
+// rest evenly.  The cutoffs are quantiles of the average bid over bids (not auctions).  As in
+// calc_auction_type_probs.m, type 1 takes average bids above the first cutoff and the range tested
+// for each later type but the last is empty, so with more than two types those start at
+// .25/(numUnobsAucTypes - 1); it is kept so that the two programs give the same results.
+vector<double> initialTypeProbs(const vector<Bid>& bids, const AuctionIndex& index, int numUnobsAucTypes){
+
+    int K = numUnobsAucTypes;
+    vector<double> typeProbs(bids.size()*K, 1);
+    if( K == 1 ){
+        return( typeProbs );
+    }
+
+    // Average bid of each bid's auction
+    vector<double> avgBid(bids.size());
+    for(size_t a = 0; a + 1 < index.auctionStart.size(); a++){
+        double sum = 0;
+        for(size_t n = index.auctionStart[a]; n < index.auctionStart[a + 1]; n++){
+            sum += bids[index.bidOrder[n]].amount;
+        }
+        double mean = sum / (index.auctionStart[a + 1] - index.auctionStart[a]);
+        for(size_t n = index.auctionStart[a]; n < index.auctionStart[a + 1]; n++){
+            avgBid[index.bidOrder[n]] = mean;
+        }
+    }
+    vector<double> sorted = avgBid;
+    sort(sorted.begin(), sorted.end());
+    vector<double> cutoffs(K - 1);
+    for(int q = 0; q < K - 1; q++){
+        cutoffs[q] = matlabQuantile(sorted, (double)(q + 1) / K);
+    }
+
+    for(size_t i = 0; i < bids.size(); i++){
+        double total = 0;
+        for(int k = 0; k < K - 1; k++){
+            bool inQuantile = (avgBid[i] >= cutoffs[k]);
+            if( k > 0 ){
+                inQuantile = inQuantile && (avgBid[i] < cutoffs[k - 1]);
+            }
+            typeProbs[i*K + k] = (inQuantile ? .75 : .25 / (K - 1));
+            total += typeProbs[i*K + k];
+        }
+        typeProbs[i*K + K - 1] = 1 - total;
+    }
+    return( typeProbs );
+}
+
+
+// One iteration of iterate_type_probs.m
+double iterateTypeProbs(const vector<Bid>& bids, const AuctionIndex& index, AucTraits aucTraits,
+                        const TypeProbSettings& settings, const vector<double>& typeProbs, int numThreads,
+                        vector<double>& updatedProbs){
+
+    int K = settings.numUnobsAucTypes;
+    int numPoints = settings.numPoints;
+    int numCells = aucTraits.numBidderTypes*aucTraits.numObsAucTypes;
+    size_t numAuctions = index.auctionStart.size() - 1;
+
+    //// Part 1: weighted kernel densities of the bids in each cell, for each unobserved type
+
+    // Evaluation points from the smallest nonnegative bid to 1.05 times the largest, as linspace()
+    // gives them, and the support [smallest point - 1, largest point]
+    double minPoint = HUGE_VAL;
+    double maxAmount = -HUGE_VAL;
+    for(size_t i = 0; i < bids.size(); i++){
+        if( bids[i].amount >= 0 ){
+            minPoint = min(minPoint, bids[i].amount);
+        }
+        maxAmount = max(maxAmount, bids[i].amount);
+    }
+    double maxPoint = 1.05*maxAmount;
+    vector<double> points(numPoints);
+    for(int j = 0; j < numPoints; j++){
+        points[j] = (j == numPoints - 1 ? maxPoint : minPoint + j*(maxPoint - minPoint)/(numPoints - 1));
+    }
+
+    // List the rows of each cell with a counting sort, so that each cell's density can be estimated
+    // on its own thread
+    vector<size_t> cellStart(numCells + 1, 0);
+    for(size_t i = 0; i < bids.size(); i++){
+        cellStart[(bids[i].bidderType - 1)*aucTraits.numObsAucTypes + bids[i].obsAucType]++;
+    }
+    for(int c = 0; c < numCells; c++){
+        cellStart[c + 1] += cellStart[c];
+    }
+    vector<size_t> cellRows(bids.size());
+    vector<size_t> nextRow(cellStart.begin(), cellStart.end() - 1);
+    for(size_t i = 0; i < bids.size(); i++){
+        cellRows[nextRow[(bids[i].bidderType - 1)*aucTraits.numObsAucTypes + bids[i].obsAucType - 1]++] = i;
+    }
+
+    // One binned estimate per cell gives the densities of every unobserved type (see weighted_kde.hpp)
+    KdeSettings kdeSettings;
+    kdeSettings.lower = minPoint - 1;
+    kdeSettings.upper = maxPoint;
+    kdeSettings.bandwidth = settings.bandwidth;
+    kdeSettings.lowProb = settings.lowProb;
+    kdeSettings.numBins = settings.kdeBins;
+    vector<double> densities((size_t)numCells*K*numPoints);
+    runTasks(numCells, numThreads, [&](size_t c){
+        WeightedKde kde(kdeSettings, points, K);
+        for(size_t n = cellStart[c]; n < cellStart[c + 1]; n++){
+            kde.add(bids[cellRows[n]].amount, &typeProbs[cellRows[n]*K]);
+        }
+        vector<double> cellDensities;
+        kde.densities(cellDensities);
+        copy(cellDensities.begin(), cellDensities.end(), densities.begin() + c*K*numPoints);
+    });
+
+    //// Part 2: update each auction's type probabilities from the densities of its bids
+
+    // The prior is the average over auctions of their current type probabilities
+    vector<double> logAvgProbs(K, 0);
+    for(size_t a = 0; a < numAuctions; a++){
+        size_t first = index.bidOrder[index.auctionStart[a]];
+        for(int k = 0; k < K; k++){
+            logAvgProbs[k] += typeProbs[first*K + k];
+        }
+    }
+    for(int k = 0; k < K; k++){
+        logAvgProbs[k] = log(logAvgProbs[k] / numAuctions);
+    }
+
+    updatedProbs.resize(typeProbs.size());
+    vector<double> auctionChange(numAuctions);
+    runTasks((numAuctions + updateTaskAuctions - 1) / updateTaskAuctions, numThreads, [&](size_t t){
+        vector<double> f(K);
+        size_t end = min(numAuctions, (t + 1)*updateTaskAuctions);
+        for(size_t a = t*updateTaskAuctions; a < end; a++){
+
+            // Log prior plus the log density of each bid other than the outside option, taken at the
+            // density point that iterate_type_probs.m picks for its amount
+            f = logAvgProbs;
+            for(size_t n = index.auctionStart[a]; n < index.auctionStart[a + 1]; n++){
+                const Bid& bid = bids[index.bidOrder[n]];
+                if( bid.amount <= 0 ){
+                    continue;
+                }
+                int j = (int)max(round(numPoints*(bid.amount - minPoint)/(maxPoint - minPoint)), 1.0) - 1;
+                j = min(j, numPoints - 1);
+                int c = (bid.bidderType - 1)*aucTraits.numObsAucTypes + bid.obsAucType - 1;
+                for(int k = 0; k < K; k++){
+                    f[k] += log(densities[(c*K + k)*numPoints + j]);
+                }
+            }
+
+            // Posterior probabilities, and the change from the current ones
+            double maxF = *max_element(f.begin(), f.end());
+            double expSum = 0;
+            for(int k = 0; k < K; k++){
+                f[k] = exp(f[k] - maxF);
+                expSum += f[k];
+            }
+            size_t first = index.bidOrder[index.auctionStart[a]];
+            double change = 0;
+            for(int k = 0; k < K; k++){
+                f[k] /= expSum;
+                change += fabs(typeProbs[first*K + k] - f[k]);
+            }
+            auctionChange[a] = change;
+            for(size_t n = index.auctionStart[a]; n < index.auctionStart[a + 1]; n++){
+                for(int k = 0; k < K; k++){
+                    updatedProbs[index.bidOrder[n]*K + k] = f[k];
+                }
+            }
+        }
+    });
+
+    double totalChange = 0;
+    for(size_t a = 0; a < numAuctions; a++){
+        totalChange += auctionChange[a];
+    }
+    return( totalChange / (2*numAuctions) );
+}
+
+
+//// Output files
+
+// Open a file for writing, printing an error if it can't be
+static FILE *openOutput(const char *fileName){
+    FILE *outFile = fopen(fileName, "w");
+    if( outFile == NULL ){
+        cout << "Error: could not write " << fileName << ".\n";
+    }
+    return( outFile );
+}
+
+// Close a file, printing an error if any write to it failed
+static bool closeOutput(FILE *outFile, const char *fileName){
+    bool failed = (ferror(outFile) != 0);
+    failed |= (fclose(outFile) != 0);
+    if( failed ){
+        cout << "Error: could not finish writing " << fileName << ".\n";
+    }
+    return( !failed );
+}
+
+// Separator before column col of numCols in unobs_auc_type_probs.csv.  The MATLAB code builds its
+// formats with strcat(), which drops the trailing space of the repeated part, so the columns are
+// separated by ", " and a single column starts with a space.
+static const char *typeProbSeparator(int col, int numCols){
+    if( col == 0 ){
+        return( numCols == 1 ? " " : "" );
+    }
+    return( ", " );
+}
+
+bool writeTypeProbs(const char *fileName, const vector<double>& typeProbs, int numUnobsAucTypes){
+
+    FILE *outFile = openOutput(fileName);
+    if( outFile == NULL ){
+        return( false );
+    }
+    int K = numUnobsAucTypes;
+    for(int k = 0; k < K; k++){
+        fprintf(outFile, "%stype_%d_prob", typeProbSeparator(k, K), k + 1);
+    }
+    fprintf(outFile, "\n");
+    for(size_t i = 0; i < typeProbs.size() / K; i++){
+        for(int k = 0; k < K; k++){
+            fprintf(outFile, "%s%1.8f", typeProbSeparator(k, K), typeProbs[i*K + k]);
+        }
+        fprintf(outFile, "\n");
+    }
+    return( closeOutput(outFile, fileName) );
+}
+
+// Write rows of shares, one row per observed auction type, as "%6.10f" separated by commas
+static bool writeShares(const char *fileName, const vector< vector<double> >& shares){
+
+    FILE *outFile = openOutput(fileName);
+    if( outFile == NULL ){
+        return( false );
+    }
+    for(size_t row = 0; row < shares.size(); row++){
+        for(size_t col = 0; col < shares[row].size(); col++){
+            fprintf(outFile, "%6.10f%s", shares[row][col], (col + 1 < shares[row].size()) ? "," : "\n");
+        }
+    }
+    return( closeOutput(outFile, fileName) );
+}
+
+// An auction with bids in more than one observed auction type counts toward each, as in the
+// MATLAB code
+vector< vector<double> > numBidDistribution(const vector<Bid>& bids, const AuctionIndex& index, AucTraits aucTraits,
+                                            const vector<double>& auctionWeights){
+
+    size_t numAuctions = index.auctionStart.size() - 1;
+    size_t maxAuctionBids = 0;
+    for(size_t a = 0; a < numAuctions; a++){
+        maxAuctionBids = max(maxAuctionBids, index.auctionStart[a + 1] - index.auctionStart[a]);
+    }
+
+    vector< vector<double> > shares(aucTraits.numObsAucTypes, vector<double>(maxAuctionBids, 0));
+    vector<double> totals(aucTraits.numObsAucTypes, 0);
+    vector<char> inType(aucTraits.numObsAucTypes);
+    for(size_t a = 0; a < numAuctions; a++){
+        size_t numBids = index.auctionStart[a + 1] - index.auctionStart[a];
+        fill(inType.begin(), inType.end(), 0);
+        for(size_t n = index.auctionStart[a]; n < index.auctionStart[a + 1]; n++){
+            inType[bids[index.bidOrder[n]].obsAucType - 1] = 1;
+        }
+        for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+            if( inType[j] ){
+                shares[j][numBids - 1] += auctionWeights[a];
+                totals[j] += auctionWeights[a];
+            }
+        }
+    }
+    for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+        for(size_t i = 0; i < maxAuctionBids; i++){
+            shares[j][i] /= totals[j];
+        }
+    }
+    return( shares );
+}
+
+vector< vector<double> > bidderTypeDistribution(const vector<Bid>& bids, const AuctionIndex& index, AucTraits aucTraits,
+                                                const vector<double>& auctionWeights){
+
+    vector< vector<double> > shares(aucTraits.numObsAucTypes, vector<double>(aucTraits.numBidderTypes, 0));
+    vector<double> totals(aucTraits.numObsAucTypes, 0);
+    for(size_t a = 0; a + 1 < index.auctionStart.size(); a++){
+        for(size_t n = index.auctionStart[a]; n < index.auctionStart[a + 1]; n++){
+            const Bid& bid = bids[index.bidOrder[n]];
+            shares[bid.obsAucType - 1][bid.bidderType - 1] += auctionWeights[a];
+            totals[bid.obsAucType - 1] += auctionWeights[a];
+        }
+    }
+    for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+        for(int i = 0; i < aucTraits.numBidderTypes; i++){
+            shares[j][i] /= totals[j];
+        }
+    }
+    return( shares );
+}
+
+bool writeNumBidDistribution(const char *fileName, const vector<Bid>& bids, const AuctionIndex& index,
+                             AucTraits aucTraits){
+    vector<double> auctionWeights(index.auctionStart.size() - 1, 1);
+    return( writeShares(fileName, numBidDistribution(bids, index, aucTraits, auctionWeights)) );
+}
+
+bool writeBidderTypeDistribution(const char *fileName, const vector<Bid>& bids, const AuctionIndex& index,
+                                 AucTraits aucTraits){
+    vector<double> auctionWeights(index.auctionStart.size() - 1, 1);
+    return( writeShares(fileName, bidderTypeDistribution(bids, index, aucTraits, auctionWeights)) );
+}
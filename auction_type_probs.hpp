@@ -0,0 +1,77 @@
+// auction_type_probs.hpp
+// Estimating the probability that each auction is of each unobserved auction type, as
+// calc_auction_type_probs.m and iterate_type_probs.m do, without MATLAB.  Each iteration estimates
+// the density of bids in every (bidder type, observed auction type, unobserved auction type) cell,
+// weighting each bid by its auction's current type probability, then updates every auction's type
+// probabilities from the densities of its bids.  The bids are grouped by auction once, so an
+// iteration is one pass over the bids rather than a scan of the table for every auction.  The
+// densities are binned estimates (weighted_kde.hpp), one per cell for all unobserved types, and
+// both halves of an iteration run in parallel with results that don't depend on the number of
+// threads.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef AUCTION_TYPE_PROBS_INCLUDED
+#define AUCTION_TYPE_PROBS_INCLUDED
+
+#include <stddef.h>
+#include <vector>
+#include "bid_selection.hpp"
+
+
+// The bids grouped by auction, in increasing order of auction ID (the order of unique() in MATLAB):
+// the bids of auction a are bids[bidOrder[auctionStart[a]]], ..., bids[bidOrder[auctionStart[a + 1] - 1]],
+// in file order
+typedef struct {
+    std::vector<size_t> bidOrder;
+    std::vector<size_t> auctionStart;
+} AuctionIndex;
+
+// Settings of the estimation; the defaults are those of the MATLAB code
+typedef struct {
+    int numUnobsAucTypes;   // unobserved auction types to estimate
+    int numPoints;          // points at which the bid densities are evaluated (100)
+    double bandwidth;       // kernel bandwidth, after the log transformation for bounded support (0.1)
+    double lowProb;         // floor on each density (1e-6)
+    int kdeBins;            // nodes of the grid the densities are binned on (see weighted_kde.hpp)
+    double tolerance;       // stop once the mean absolute change in the probabilities is at most this (1e-6)
+    int maxIterations;      // give up after this many iterations
+} TypeProbSettings;
+
+// Group the bids by auction
+AuctionIndex indexAuctions(const std::vector<Bid>& bids);
+
+// Initial type probabilities of each bid (numUnobsAucTypes per bid, row by row), from where the
+// average bid of its auction falls among the quantiles of the average bids, as in
+// calc_auction_type_probs.m
+std::vector<double> initialTypeProbs(const std::vector<Bid>& bids, const AuctionIndex& index, int numUnobsAucTypes);
+
+// One iteration: estimate the bid densities with weights typeProbs, then set updatedProbs to the
+// posterior type probabilities of every auction's bids.  Returns the convergence criterion, the
+// summed absolute change in each auction's probabilities over twice the number of auctions.
+double iterateTypeProbs(const std::vector<Bid>& bids, const AuctionIndex& index, AucTraits aucTraits,
+                        const TypeProbSettings& settings, const std::vector<double>& typeProbs, int numThreads,
+                        std::vector<double>& updatedProbs);
+
+// Write the outputs in the formats of calc_auction_type_probs.m.  Each returns false (after
+// printing an error) if the file can't be written.
+//   unobs_auc_type_probs.csv: a header, then the type probabilities of each bid
+//   num_bid_distribution.csv: for each observed auction type, the share of auctions with 1, 2, ...
+//                             bids, up to the largest auction
+//   bidder_type_distribution.csv: for each observed auction type, the share of bids by each bidder type
+bool writeTypeProbs(const char *fileName, const std::vector<double>& typeProbs, int numUnobsAucTypes);
+bool writeNumBidDistribution(const char *fileName, const std::vector<Bid>& bids, const AuctionIndex& index,
+                             AucTraits aucTraits);
+bool writeBidderTypeDistribution(const char *fileName, const std::vector<Bid>& bids, const AuctionIndex& index,
+                                 AucTraits aucTraits);
+
+// The shares written to num_bid_distribution.csv and bidder_type_distribution.csv (one row per
+// observed auction type), with auction a counted auctionWeights[a] times, as in a bootstrap
+// resample of the auctions (cost_bootstrap.hpp).  A row whose auctions all have weight zero is NaN.
+std::vector< std::vector<double> > numBidDistribution(const std::vector<Bid>& bids, const AuctionIndex& index,
+                                                      AucTraits aucTraits, const std::vector<double>& auctionWeights);
+std::vector< std::vector<double> > bidderTypeDistribution(const std::vector<Bid>& bids, const AuctionIndex& index,
+                                                          AucTraits aucTraits, const std::vector<double>& auctionWeights);
+
+
+// End header guard with endif statement
+#endif
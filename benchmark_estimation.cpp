@@ -0,0 +1,410 @@
+// benchmark_estimation.cpp
+// Microbenchmarks for the hot paths of the estimation: importing the sample bids and distributions,
+// loading the bids, drawing competitors, and simulating auctions.  The inputs are synthetic (see
+// synthetic_data.hpp) and generated from a fixed seed, so runs on the same machine are repeatable
+// and can be compared before and after a change.  Each benchmark is run several times and the
+// median time is reported, both on screen and as a CSV file.
+// Compiled as: g++ -O2 -pthread -o benchmark_estimation.exe benchmark_estimation.cpp synthetic_data.cpp bid_selection.cpp import_data.cpp alias_table.cpp sample_bid_store.cpp nested_logit_kernel.cpp competitor_draws.cpp sobol_sequence.cpp bid_data_loader.cpp
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "import_data.hpp"
+#include "bid_data_loader.hpp"
+#include "nested_logit_kernel.hpp"
+#include "synthetic_data.hpp"
+#include <chrono> // For timing the benchmarks
+#include <new> // For counting the bytes allocated with operator new
+#include <unistd.h> // For chdir() and getcwd()
+#include <sys/stat.h> // For mkdir()
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+//// Counting allocations
+
+// Every allocation through operator new (vectors, strings, streams) adds its size here, including
+// new[] and the nothrow forms, which the standard library forwards to it.  Not counted: the
+// over-aligned operator new (types with alignas above 16), and anything allocated with malloc() or
+// aligned_alloc() directly, such as the sample bid store.
+static atomic<size_t> bytesAllocatedCount(0);
+
+void *operator new(size_t size){
+    bytesAllocatedCount.fetch_add(size, memory_order_relaxed);
+    void *memory = malloc(size > 0 ? size : 1);
+    if( memory == NULL ){
+        throw bad_alloc();
+    }
+    return( memory );
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+
+//// Inputs
+
+// Size of a file in bytes (0 if it can't be read)
+static size_t fileBytes(const char *fileName){
+    struct stat fileInfo;
+    if( stat(fileName, &fileInfo) != 0 ){
+        return( 0 );
+    }
+    return( fileInfo.st_size );
+}
+
+
+//// Benchmarks
+
+// Everything the benchmarks read, loaded once before timing
+typedef struct {
+    SyntheticDataParams sizes; // parameters of the synthetic inputs
+    int numSims;               // simulated auctions per call in the simulation benchmarks
+    AucTraits aucTraits;
+    SampleBidManifest manifest;
+    SampleBidStore *sampleBids;
+    BidSelectionParams nlp;
+    vector<AliasTable> numBidDist;
+    vector<AliasTable> bidderTypeDist;
+    vector<Bid> bids;
+} BenchmarkInputs;
+
+// A benchmark runs its operation once over the inputs and returns the number of operations,
+// adding the bytes of input it parsed to bytesParsed
+typedef size_t (*BenchmarkFunction)(const BenchmarkInputs& inputs, size_t& bytesParsed);
+
+// Results are written here so that the compiler can't drop the work being timed
+static volatile double benchmarkSink;
+
+// Start of the timed section of the current benchmark, and the allocation count at that point.
+// runBenchmark() sets both before calling a benchmark; a benchmark with setup it shouldn't be
+// charged for calls startTimedSection() once the setup is done.
+static chrono::steady_clock::time_point timedSectionStart;
+static size_t timedSectionBytes;
+
+static void startTimedSection(){
+    timedSectionBytes = bytesAllocatedCount.load();
+    timedSectionStart = chrono::steady_clock::now();
+}
+
+// Import every sample bid file on numThreads threads; one operation is one sample bid
+static size_t importSampleBidFiles(const BenchmarkInputs& inputs, int numThreads, size_t& bytesParsed){
+    SampleBidStore sampleBids(inputs.aucTraits, inputs.sizes.numSamples);
+    // importSampleBids() prints a summary line; keep that off the screen while timing
+    cout.setstate(ios::failbit);
+    bool imported = importSampleBids(sampleBids, inputs.manifest, numThreads);
+    cout.clear();
+    if( !imported ){
+        cout << "Error: could not import the synthetic sample bids.\n";
+        exit(1);
+    }
+    for(size_t cell = 0; cell < inputs.manifest.files.size(); cell++){
+        bytesParsed += inputs.manifest.files[cell].bytes;
+    }
+    benchmarkSink = sampleBids.amount(0, 0);
+    return( (size_t)sampleBids.numCells() * sampleBids.numSamples() );
+}
+
+// Import the sample bids one file at a time
+static size_t benchImportSampleBids(const BenchmarkInputs& inputs, size_t& bytesParsed){
+    return( importSampleBidFiles(inputs, 1, bytesParsed) );
+}
+
+// Import the sample bids on every available core
+static size_t benchImportSampleBidsThreaded(const BenchmarkInputs& inputs, size_t& bytesParsed){
+    return( importSampleBidFiles(inputs, max(1u, thread::hardware_concurrency()), bytesParsed) );
+}
+
+// Parse sample bid lines; one operation is one line
+static size_t benchGetSampleBid(const BenchmarkInputs& /* inputs */, size_t& bytesParsed){
+    const char *lines[4] = {"278.6455, 1\n", "183.4834, 2\n", "301.2500, 3\n", "99.0001, 1\n"};
+    const int numLines = 1000000;
+    double amountSum = 0;
+    for(int n = 0; n < numLines; n++){
+        const char *line = lines[n & 3];
+        amountSum += getSampleBid(line).amount;
+        bytesParsed += strlen(line);
+    }
+    benchmarkSink = amountSum;
+    return( numLines );
+}
+
+// Import the number-of-bids distribution; one operation is one import
+static size_t benchImportNumBidDist(const BenchmarkInputs& inputs, size_t& bytesParsed){
+    const int numImports = 1000;
+    for(int n = 0; n < numImports; n++){
+        vector<AliasTable> numBidDist = importNumBidDist(inputs.aucTraits);
+        benchmarkSink = numBidDist[0].size();
+        bytesParsed += fileBytes("num_bid_distribution.csv");
+    }
+    return( numImports );
+}
+
+// Import the bidder type distribution; one operation is one import
+static size_t benchImportBidderTypeDist(const BenchmarkInputs& inputs, size_t& bytesParsed){
+    const int numImports = 1000;
+    for(int n = 0; n < numImports; n++){
+        vector<AliasTable> bidderTypeDist = importBidderTypeDist(inputs.aucTraits);
+        benchmarkSink = bidderTypeDist[0].size();
+        bytesParsed += fileBytes("bidder_type_distribution.csv");
+    }
+    return( numImports );
+}
+
+// Load template_data.csv on one thread; one operation is one row
+static size_t benchLoadBidData(const BenchmarkInputs& /* inputs */, size_t& bytesParsed){
+    vector<Bid> bids;
+    if( !loadBidData("template_data.csv", NULL, 1, bids) ){
+        exit(1);
+    }
+    bytesParsed += fileBytes("template_data.csv");
+    benchmarkSink = bids.back().amount;
+    return( bids.size() );
+}
+
+// The first bid that isn't an outside option, which the simulation benchmarks evaluate
+static const Bid& focalBid(const BenchmarkInputs& inputs){
+    size_t i = 0;
+    while( inputs.bids[i].bidderType == 0 ){
+        i++;
+    }
+    return( inputs.bids[i] );
+}
+
+// Draw banks of competitors, reusing one bank as calculate_costs.exe does; one operation is one
+// simulated auction
+static size_t benchCompetitorDraws(const BenchmarkInputs& inputs, size_t& /* bytesParsed */){
+    const int numBanks = 20;
+    const Bid& bid = focalBid(inputs);
+    CompetitorDraws competitorDraws;
+    for(int n = 0; n < numBanks; n++){
+        competitorDraws.draw(inputs.sizes.seed, n, 0, 0, inputs.numSims, inputs.numBidDist[bid.obsAucType - 1],
+                             inputs.bidderTypeDist[bid.obsAucType - 1], inputs.sizes.numSamples);
+    }
+    benchmarkSink = competitorDraws.maxOtherBids();
+    return( (size_t)numBanks * inputs.numSims );
+}
+
+// Simulate auctions for one bid against a bank drawn beforehand; one operation is one simulated
+// auction
+static size_t benchSimulateAuctions(const BenchmarkInputs& inputs, size_t& /* bytesParsed */){
+    const int numCalls = 20;
+    const Bid& bid = focalBid(inputs);
+    AuctionScratch scratch(inputs.numBidDist);
+    CompetitorDraws competitorDraws;
+    competitorDraws.draw(inputs.sizes.seed, 0, 0, 0, inputs.numSims, inputs.numBidDist[bid.obsAucType - 1],
+                         inputs.bidderTypeDist[bid.obsAucType - 1], inputs.sizes.numSamples);
+    startTimedSection();
+    double probSum = 0;
+    for(int n = 0; n < numCalls; n++){
+        SimulationSums sums = simulateAuctions(bid, n % inputs.aucTraits.numUnobsAucTypes, competitorDraws, 0,
+                                               inputs.numSims, *inputs.sampleBids, inputs.nlp, scratch);
+        probSum += sums.probSum;
+    }
+    benchmarkSink = probSum;
+    return( (size_t)numCalls * inputs.numSims );
+}
+
+// Evaluate 256 bids against the inclusive values of one bank, as calculate_costs.exe --batched
+// does; one operation is one bid and simulated auction
+static size_t benchBatchedBids(const BenchmarkInputs& inputs, size_t& /* bytesParsed */){
+    const int numBids = 256;
+    const Bid& bid = focalBid(inputs);
+    CompetitorDraws competitorDraws;
+    competitorDraws.draw(inputs.sizes.seed, 0, 0, 0, inputs.numSims, inputs.numBidDist[bid.obsAucType - 1],
+                         inputs.bidderTypeDist[bid.obsAucType - 1], inputs.sizes.numSamples);
+    int paddedSims = (inputs.numSims + simBlockSize - 1) / simBlockSize * simBlockSize;
+    vector<double> logExpSums(paddedSims, 0);
+    for(int sim = 0; sim < inputs.numSims; sim++){
+        logExpSums[sim] = competitorLogExpSum(competitorDraws, sim, bid.obsAucType - 1, 0, *inputs.sampleBids, inputs.nlp);
+    }
+    vector<const Bid*> batch;
+    for(size_t i = 0; (i < inputs.bids.size()) && ((int)batch.size() < numBids); i++){
+        if( (inputs.bids[i].bidderType != 0) && (inputs.bids[i].obsAucType == bid.obsAucType) ){
+            batch.push_back(&inputs.bids[i]);
+        }
+    }
+    vector<SimulationSums> sums(batch.size());
+    startTimedSection();
+    evaluateBidsAgainstInclusiveValues(batch.data(), batch.size(), logExpSums.data(), inputs.numSims,
+                                       inputs.nlp, sums.data());
+    benchmarkSink = sums[0].probSum;
+    return( batch.size() * inputs.numSims );
+}
+
+// Timing of one benchmark: median time over the repeats, with the operations, bytes allocated, and
+// bytes parsed of one run
+typedef struct {
+    const char *name;
+    size_t ops;
+    double seconds;
+    size_t bytesAllocated;
+    size_t bytesParsed;
+} BenchmarkResult;
+
+// Run a benchmark once untimed (to warm the caches and page in the files), then numRepeats times
+static BenchmarkResult runBenchmark(const char *name, BenchmarkFunction benchmark, const BenchmarkInputs& inputs,
+                                    int numRepeats){
+
+    size_t bytesParsed = 0;
+    benchmark(inputs, bytesParsed);
+
+    BenchmarkResult result = {name, 0, 0, 0, 0};
+    vector<double> times;
+    for(int r = 0; r < numRepeats; r++){
+        bytesParsed = 0;
+        startTimedSection();
+        result.ops = benchmark(inputs, bytesParsed);
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        times.push_back( chrono::duration<double>(end - timedSectionStart).count() );
+        result.bytesAllocated = bytesAllocatedCount.load() - timedSectionBytes;
+        result.bytesParsed = bytesParsed;
+    }
+    sort(times.begin(), times.end());
+    result.seconds = times[times.size() / 2];
+    return( result );
+}
+
+
+// Command line options:
+//   --repeats R     timed runs of each benchmark, of which the median is reported (default 5)
+//   --seed S        seed for the synthetic inputs (default 1)
+//   --bids N        bids in the synthetic template_data.csv (default 200000)
+//   --sims N        simulated auctions per call in the simulation benchmarks (default 10000)
+//   --dir DIR       directory for the synthetic inputs (default benchmark_inputs)
+//   --output FILE   CSV file of results (default benchmark_results.csv)
+//   --simd KERNEL   nested logit kernel, as for calculate_costs.exe (default auto)
+int main(int argc, char *argv[]){
+
+    // Read command line options
+    int numRepeats = 5;
+    SyntheticDataParams sizes;
+    sizes.seed = 1;
+    sizes.numBids = 200000;
+    sizes.aucTraits.numBidderTypes = 3;
+    sizes.aucTraits.numObsAucTypes = 2;
+    sizes.aucTraits.numUnobsAucTypes = 2;
+    sizes.maxAuctionSize = 7;
+    sizes.numSamples = 10000;
+    BidSelectionParams coeffs = {-0.02, 0.3, 0.7, 1.5, 0.1, 0.05, -0.2, nestedLogitModel};
+    sizes.coeffs = coeffs;
+    int numSims = 10000;
+    const char *inputDir = "benchmark_inputs";
+    const char *outputFile = "benchmark_results.csv";
+    const char *kernelName = "auto";
+    for(int i = 1; i < argc; i++){
+        if( (strcmp(argv[i], "--repeats") == 0) && (i + 1 < argc) ){
+            numRepeats = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--seed") == 0) && (i + 1 < argc) ){
+            sizes.seed = strtoull(argv[++i], NULL, 10);
+        } else if( (strcmp(argv[i], "--bids") == 0) && (i + 1 < argc) ){
+            sizes.numBids = atoll(argv[++i]);
+        } else if( (strcmp(argv[i], "--sims") == 0) && (i + 1 < argc) ){
+            numSims = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--dir") == 0) && (i + 1 < argc) ){
+            inputDir = argv[++i];
+        } else if( (strcmp(argv[i], "--output") == 0) && (i + 1 < argc) ){
+            outputFile = argv[++i];
+        } else if( (strcmp(argv[i], "--simd") == 0) && (i + 1 < argc) ){
+            kernelName = argv[++i];
+        } else {
+            cout << "Error: unrecognized option " << argv[i] << ".\n";
+            cout << "Usage: benchmark_estimation.exe [--repeats R] [--seed S] [--bids N] [--sims N] [--dir DIR]"
+                 << " [--output FILE] [--simd auto|scalar|avx2|avx512]\n";
+            return(1);
+        }
+    }
+    if( (numRepeats <= 0) | (sizes.numBids <= 0) | (numSims <= 0) ){
+        cout << "Error: --repeats, --bids, and --sims must be positive.\n";
+        return(1);
+    }
+    if( !setNestedLogitKernel(kernelName) ){
+        cout << "Error: the " << kernelName << " kernel is unknown or not supported by this CPU.\n";
+        return(1);
+    }
+
+    // Write the inputs in their own directory, so that real data in the working directory is
+    // never overwritten, and return to the working directory for the results
+    char workingDir[4096];
+    if( getcwd(workingDir, sizeof(workingDir)) == NULL ){
+        cout << "Error: could not read the working directory.\n";
+        return(1);
+    }
+    mkdir(inputDir, 0755);
+    if( chdir(inputDir) != 0 ){
+        cout << "Error: could not enter " << inputDir << ".\n";
+        return(1);
+    }
+    cout << "Writing synthetic inputs to " << inputDir << "\n";
+    size_t bytesWritten;
+    if( !writeSyntheticData(sizes, bytesWritten) ){
+        return(1);
+    }
+
+    // Load the inputs as calculate_costs.exe would
+    BenchmarkInputs inputs;
+    inputs.sizes = sizes;
+    inputs.numSims = numSims;
+    if( !readSampleBidManifest(sampleBidManifestFile, inputs.manifest) ){
+        return(1);
+    }
+    inputs.aucTraits = inputs.manifest.aucTraits;
+    SampleBidStore sampleBids(inputs.aucTraits, sizes.numSamples);
+    cout.setstate(ios::failbit);
+    bool imported = importSampleBids(sampleBids, inputs.manifest, 1);
+    cout.clear();
+    if( !imported || !loadBidData("template_data.csv", NULL, 1, inputs.bids) ){
+        return(1);
+    }
+    inputs.sampleBids = &sampleBids;
+    inputs.nlp = getBidSelectionParams();
+    inputs.numBidDist = importNumBidDist(inputs.aucTraits);
+    inputs.bidderTypeDist = importBidderTypeDist(inputs.aucTraits);
+
+    // Run the benchmarks
+    cout << "Running each benchmark " << numRepeats << " times with the " << nestedLogitKernelName() << " kernel\n";
+    vector<BenchmarkResult> results;
+    results.push_back( runBenchmark("importSampleBids", benchImportSampleBids, inputs, numRepeats) );
+    results.push_back( runBenchmark("importSampleBidsThreaded", benchImportSampleBidsThreaded, inputs, numRepeats) );
+    results.push_back( runBenchmark("getSampleBid", benchGetSampleBid, inputs, numRepeats) );
+    results.push_back( runBenchmark("importNumBidDist", benchImportNumBidDist, inputs, numRepeats) );
+    results.push_back( runBenchmark("importBidderTypeDist", benchImportBidderTypeDist, inputs, numRepeats) );
+    results.push_back( runBenchmark("loadBidData", benchLoadBidData, inputs, numRepeats) );
+    results.push_back( runBenchmark("competitorDraws", benchCompetitorDraws, inputs, numRepeats) );
+    results.push_back( runBenchmark("simulateAuctions", benchSimulateAuctions, inputs, numRepeats) );
+    results.push_back( runBenchmark("batchedBids", benchBatchedBids, inputs, numRepeats) );
+
+    if( chdir(workingDir) != 0 ){
+        cout << "Error: could not return to " << workingDir << ".\n";
+        return(1);
+    }
+
+    // Report: time per operation, operations per second, bytes allocated per operation, and
+    // megabytes of input parsed per second (0 for benchmarks that parse nothing)
+    FILE *outFile = fopen(outputFile, "w");
+    if( outFile == NULL ){
+        cout << "Error: could not write " << outputFile << ".\n";
+        return(1);
+    }
+    fprintf(outFile, "benchmark, kernel, ops, ns_per_op, ops_per_sec, bytes_allocated_per_op, mb_per_sec\n");
+    printf("%-26s %12s %14s %16s %10s\n", "benchmark", "ns/op", "ops/sec", "alloc bytes/op", "MB/s");
+    for(size_t b = 0; b < results.size(); b++){
+        const BenchmarkResult& result = results[b];
+        double nsPerOp = 1e9 * result.seconds / result.ops;
+        double opsPerSec = result.ops / result.seconds;
+        double allocPerOp = (double)result.bytesAllocated / result.ops;
+        double mbPerSec = result.bytesParsed / result.seconds / 1e6;
+        fprintf(outFile, "%s, %s, %zu, %.3f, %.1f, %.3f, %.2f\n", result.name, nestedLogitKernelName(), result.ops,
+                nsPerOp, opsPerSec, allocPerOp, mbPerSec);
+        printf("%-26s %12.2f %14.0f %16.3f %10.2f\n", result.name, nsPerOp, opsPerSec, allocPerOp, mbPerSec);
+    }
+    fclose(outFile);
+    cout << "Results written to " << outputFile << "\n";
+
+    return 0;
+}
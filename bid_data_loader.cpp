@@ -0,0 +1,326 @@
+// bid_data_loader.cpp
+// Implementing the parallel bid data loader declared in bid_data_loader.hpp
+
+#include "bid_data_loader.hpp"
+#include <charconv>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+using namespace std;
+
+
+// Chunks are at least this many bytes, so that small files are parsed on one thread
+static const size_t minChunkBytes = 1 << 20;
+
+
+// Remove spaces, tabs, and carriage returns from both ends of [begin, end)
+static void trim(const char *&begin, const char *&end){
+    while( (begin < end) && ((*begin == ' ') || (*begin == '\t')) ){
+        begin++;
+    }
+    while( (end > begin) && ((end[-1] == ' ') || (end[-1] == '\t') || (end[-1] == '\r')) ){
+        end--;
+    }
+}
+
+// End of the line starting at p (the newline, or end if there is none)
+static const char *lineEnd(const char *p, const char *end){
+    const char *newline = (const char*)memchr(p, '\n', end - p);
+    return( newline != NULL ? newline : end );
+}
+
+// Whether a line has nothing but whitespace
+static bool isBlank(const char *begin, const char *end){
+    trim(begin, end);
+    return( begin == end );
+}
+
+
+// One chunk of whole lines, and what parsing it found
+typedef struct {
+    const char *begin;
+    const char *end;
+    size_t numLines;      // lines in the chunk, blank or not
+    size_t numRows;       // non-blank lines
+    size_t firstLine;     // line number (from 1, counting the header) of the chunk's first line
+    size_t firstRow;      // index in bids of the chunk's first row
+    size_t numMalformed;  // rows that couldn't be parsed
+    size_t errorLine;     // line number of the first of them
+    string error;         // and what was wrong with it
+} BidChunk;
+
+// First pass: count the lines and rows of a chunk, so that each chunk knows where its rows go
+static void countChunk(BidChunk& chunk){
+    chunk.numLines = 0;
+    chunk.numRows = 0;
+    for(const char *p = chunk.begin; p < chunk.end; ){
+        const char *stop = lineEnd(p, chunk.end);
+        chunk.numLines++;
+        if( !isBlank(p, stop) ){
+            chunk.numRows++;
+        }
+        p = stop + 1;
+    }
+}
+
+// Second pass: parse the rows of a chunk into bids[chunk.firstRow], ...
+// columnFields[c] is the index in bidFields of the field that column c fills, or -1
+static void parseChunk(BidChunk& chunk, const vector<int>& columnFields, const vector<string>& columnNames,
+                       vector<Bid>& bids){
+
+    chunk.numMalformed = 0;
+    size_t row = chunk.firstRow;
+    size_t lineNumber = chunk.firstLine;
+    int numCols = columnFields.size();
+
+    for(const char *p = chunk.begin; p < chunk.end; lineNumber++){
+        const char *stop = lineEnd(p, chunk.end);
+        const char *line = p;
+        p = stop + 1;
+        if( isBlank(line, stop) ){
+            continue;
+        }
+
+        Bid& bid = bids[row++];
+        string error;
+        int col = 0;
+        const char *field = line;
+        while( error.empty() ){
+            const char *fieldEnd = (const char*)memchr(field, ',', stop - field);
+            if( fieldEnd == NULL ){
+                fieldEnd = stop;
+            }
+
+            if( (col < numCols) && (columnFields[col] >= 0) ){
+                const BidField& target = bidFields[ columnFields[col] ];
+                const char *begin = field;
+                const char *end = fieldEnd;
+                trim(begin, end);
+                char *destination = (char*)&bid + target.offset;
+                from_chars_result result;
+                if( target.type == doubleField ){
+                    result = from_chars(begin, end, *(double*)destination);
+                } else {
+                    result = from_chars(begin, end, *(int*)destination);
+                }
+                if( (begin == end) || (result.ec != errc()) || (result.ptr != end) ){
+                    error = "could not read '" + string(begin, end) + "' in column " + columnNames[col] +
+                        " as " + (target.type == doubleField ? "a number" : "an integer");
+                }
+            }
+
+            col++;
+            if( fieldEnd == stop ){
+                break;
+            }
+            field = fieldEnd + 1;
+        }
+        if( error.empty() && (col != numCols) ){
+            error = "the row has " + to_string(col) + " columns but the header has " + to_string(numCols);
+        }
+
+        if( !error.empty() ){
+            if( chunk.numMalformed == 0 ){
+                chunk.errorLine = lineNumber;
+                chunk.error = error;
+            }
+            chunk.numMalformed++;
+        }
+    }
+}
+
+
+// Read the column mapping file into columnOf (the column header for each field of bidFields)
+static bool readColumnMapping(const char *columnFile, vector<string>& columnOf){
+
+    if( columnFile == NULL ){
+        return( true ); // No file given: keep the defaults
+    }
+    FILE *mappingFile = fopen(columnFile, "r");
+    if( mappingFile == NULL ){
+        return( true ); // No file: keep the defaults
+    }
+
+    char line[1000];
+    int lineNumber = 0;
+    bool ok = true;
+    while( ok && (fgets(line, sizeof(line), mappingFile) != NULL) ){
+        lineNumber++;
+        // Drop comments, then skip blank lines
+        char *comment = strchr(line, '#');
+        if( comment != NULL ){
+            *comment = '\0';
+        }
+        const char *begin = line;
+        const char *end = line + strlen(line);
+        if( (end > begin) && (end[-1] == '\n') ){
+            end--;
+        }
+        if( isBlank(begin, end) ){
+            continue;
+        }
+
+        const char *equals = (const char*)memchr(begin, '=', end - begin);
+        if( equals == NULL ){
+            cout << "Error: " << columnFile << " line " << lineNumber << " should read \"field = column\".\n";
+            ok = false;
+            break;
+        }
+        const char *fieldBegin = begin;
+        const char *fieldEnd = equals;
+        const char *columnBegin = equals + 1;
+        const char *columnEnd = end;
+        trim(fieldBegin, fieldEnd);
+        trim(columnBegin, columnEnd);
+        string field(fieldBegin, fieldEnd);
+
+        int f = 0;
+        while( (f < numBidFields) && (field != bidFields[f].name) ){
+            f++;
+        }
+        if( f == numBidFields ){
+            cout << "Error: " << columnFile << " line " << lineNumber << " names unknown bid field " << field << ".\n";
+            ok = false;
+        } else {
+            columnOf[f] = string(columnBegin, columnEnd);
+        }
+    }
+    fclose(mappingFile);
+    return( ok );
+}
+
+
+// Map the file, match fields to columns, then count and parse the chunks in parallel
+bool loadBidData(const char *dataFile, const char *columnFile, int numThreads, vector<Bid>& bids){
+
+    // Column for each field: the default unless the mapping file says otherwise
+    vector<string> columnOf;
+    for(int f = 0; f < numBidFields; f++){
+        columnOf.push_back( bidFields[f].defaultColumn );
+    }
+    if( !readColumnMapping(columnFile, columnOf) ){
+        return( false );
+    }
+
+    // Map the whole file read-only
+    int fd = open(dataFile, O_RDONLY);
+    if( fd < 0 ){
+        cout << "Error: could not open " << dataFile << ".\n";
+        return( false );
+    }
+    struct stat fileStats;
+    if( (fstat(fd, &fileStats) != 0) || (fileStats.st_size == 0) ){
+        cout << "Error: " << dataFile << " is empty.\n";
+        close(fd);
+        return( false );
+    }
+    size_t fileBytes = fileStats.st_size;
+    const char *text = (const char*)mmap(NULL, fileBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if( text == MAP_FAILED ){
+        cout << "Error: could not map " << dataFile << ".\n";
+        return( false );
+    }
+    const char *textEnd = text + fileBytes;
+
+    // Split the header into column names and find the column of each field
+    const char *headerEnd = lineEnd(text, textEnd);
+    vector<string> columnNames;
+    for(const char *p = text; ; ){
+        const char *nameEnd = (const char*)memchr(p, ',', headerEnd - p);
+        if( nameEnd == NULL ){
+            nameEnd = headerEnd;
+        }
+        const char *begin = p;
+        const char *end = nameEnd;
+        trim(begin, end);
+        columnNames.push_back( string(begin, end) );
+        if( nameEnd == headerEnd ){
+            break;
+        }
+        p = nameEnd + 1;
+    }
+    vector<int> columnFields(columnNames.size(), -1);
+    for(int f = 0; f < numBidFields; f++){
+        size_t col = find(columnNames.begin(), columnNames.end(), columnOf[f]) - columnNames.begin();
+        if( col == columnNames.size() ){
+            cout << "Error: " << dataFile << " has no column " << columnOf[f] << " for bid field "
+                 << bidFields[f].name << ".\n";
+            munmap((void*)text, fileBytes);
+            return( false );
+        }
+        // Each column fills one field; a second field mapped to it would be left zero in every row
+        if( columnFields[col] >= 0 ){
+            cout << "Error: bid fields " << bidFields[columnFields[col]].name << " and " << bidFields[f].name
+                 << " are both mapped to column " << columnOf[f] << " of " << dataFile << ".\n";
+            munmap((void*)text, fileBytes);
+            return( false );
+        }
+        columnFields[col] = f;
+    }
+
+    // Split the rows after the header into chunks of whole lines
+    const char *dataStart = (headerEnd < textEnd ? headerEnd + 1 : textEnd);
+    size_t dataBytes = textEnd - dataStart;
+    size_t numChunks = max((size_t)1, min((size_t)max(numThreads, 1), dataBytes / minChunkBytes));
+    vector<BidChunk> chunks(numChunks);
+    const char *chunkStart = dataStart;
+    for(size_t i = 0; i < numChunks; i++){
+        const char *chunkEnd = textEnd;
+        if( i + 1 < numChunks ){
+            chunkEnd = lineEnd(max(chunkStart, dataStart + dataBytes*(i + 1)/numChunks), textEnd);
+            if( chunkEnd < textEnd ){
+                chunkEnd++;
+            }
+        }
+        chunks[i].begin = chunkStart;
+        chunks[i].end = chunkEnd;
+        chunkStart = chunkEnd;
+    }
+
+    // Count, then give each chunk its first line number and first row
+    vector<thread> threads;
+    for(size_t i = 0; i < numChunks; i++){
+        threads.push_back( thread(countChunk, ref(chunks[i])) );
+    }
+    for(size_t i = 0; i < numChunks; i++){
+        threads[i].join();
+    }
+    size_t numRows = 0;
+    size_t lineNumber = 2;
+    for(size_t i = 0; i < numChunks; i++){
+        chunks[i].firstRow = numRows;
+        chunks[i].firstLine = lineNumber;
+        numRows += chunks[i].numRows;
+        lineNumber += chunks[i].numLines;
+    }
+
+    // Parse each chunk into its own rows
+    bids.assign(numRows, Bid());
+    threads.clear();
+    for(size_t i = 0; i < numChunks; i++){
+        threads.push_back( thread(parseChunk, ref(chunks[i]), cref(columnFields), cref(columnNames), ref(bids)) );
+    }
+    for(size_t i = 0; i < numChunks; i++){
+        threads[i].join();
+    }
+    munmap((void*)text, fileBytes);
+
+    // Report the first malformed row, and how many there were
+    size_t numMalformed = 0;
+    for(size_t i = 0; i < numChunks; i++){
+        if( (numMalformed == 0) && (chunks[i].numMalformed > 0) ){
+            cout << "Error: " << dataFile << " line " << chunks[i].errorLine << ": " << chunks[i].error << ".\n";
+        }
+        numMalformed += chunks[i].numMalformed;
+    }
+    if( numMalformed > 0 ){
+        cout << "Error: " << numMalformed << " malformed rows in " << dataFile << ".\n";
+        return( false );
+    }
+    return( true );
+}
@@ -0,0 +1,24 @@
+// bid_data_loader.hpp
+// Loading the bids in template_data.csv.  The file is mapped into memory and split into chunks of
+// whole lines that are parsed in parallel with std::from_chars, straight from the mapped text into
+// a vector of Bids.  Which CSV column fills which Bid field comes from a column mapping file (by
+// default bid_columns.txt) on top of the defaults in bid_selection.cpp, so a change in the column
+// order or names needs no code changes.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef BID_DATA_LOADER_INCLUDED
+#define BID_DATA_LOADER_INCLUDED
+
+#include "bid_selection.hpp"
+
+
+// Load every bid in dataFile, in file order, using numThreads threads.  Blank lines are skipped.
+// columnFile has lines of the form "field = column header" ('#' starts a comment); fields it doesn't
+// mention use their default column, and a missing file (or a NULL columnFile) means every field
+// does.  Returns false (after printing an error) if the file can't be read, a column is missing, or
+// any row is malformed; malformed rows are reported by line number.
+bool loadBidData(const char *dataFile, const char *columnFile, int numThreads, std::vector<Bid>& bids);
+
+
+// End header guard with endif statement
+#endif
@@ -1,10 +1,14 @@
 // bid_selection.cpp
 // Implementing the functions and classes declared in bid_selection.hpp
-// This is the file to edit when changing the bid selection model
+// The bid selection models themselves are the policies in selection_models.hpp
 // Drew Vollmer 2018-01-17
 
 // Import the header file whose declarations we want to implement
 #include "bid_selection.hpp"
+#include "sample_bid_store.hpp"
+#include "nested_logit_kernel.hpp"
+#include "selection_models.hpp"
+#include "checkpoint.hpp"
 
 
 using namespace std;
@@ -13,36 +17,26 @@ using namespace std;
 // Data types are defined in bid_selection.hpp
 
 
-// Implement function to import bid data
-// Get bid data for the next bid in the file. Works by taking in an object referring to the file, then
-// extracting the next line (bid) and processing it.  Returns a Bid object.
-Bid getBidData(FILE *bidFile){
-
-    char line[10000];
-    char *res = fgets(line, sizeof(line), bidFile);
-
-    // Declare bid object to return and fill with the current line
-    Bid currentBid;
-    currentBid.isLastBid = !res;
-    // Also declare placeholder variables to be read into that we don't care about
-    int intToIgnore[4];
-
-    // Order and usage of data:
-    // AuctionID (ignored), BidderType (ignored), ObservedAucType, BidAmount (used),
-    // Decision (ignored), OverallDecision (ignored), [Regressors] (used)
-    sscanf(line, "%d, %d, %d, %lf, %d, %d, %d, %d, %d, %d, %d",
-           &intToIgnore[0], &currentBid.bidderType, &currentBid.obsAucType, &currentBid.amount,
-           &intToIgnore[1], &intToIgnore[2], &currentBid.sumRep, &currentBid.numReps,
-           &currentBid.previousAuctions, &currentBid.previousCancels, &intToIgnore[3]);
-    // cout << currentBid.amount << "; " << currentBid.sumRep << "; " << currentBid.numReps << "; " << currentBid.previousAuctions << "; " << currentBid.previousCancels << "; " << currentBid.bidderType << "\n";
-
-    return( currentBid );
-
-}
+// Fields of Bid read from template_data.csv and the column that fills each by default.  Other
+// columns (Decision, OverallDecision, and any extra regressors) are ignored.  The auction ID isn't
+// used by the selection model, but groups the bids of each auction in calc_auction_type_probs.exe.
+// Add a row here when adding a field to Bid; bid_columns.txt can then rename its column without
+// recompiling.
+const BidField bidFields[] = {
+    {"bidderType",       offsetof(Bid, bidderType),       intField,    "BidderType"},
+    {"obsAucType",       offsetof(Bid, obsAucType),       intField,    "OAucType"},
+    {"amount",           offsetof(Bid, amount),           doubleField, "BidAmount"},
+    {"sumRep",           offsetof(Bid, sumRep),           intField,    "SumRep"},
+    {"numReps",          offsetof(Bid, numReps),          intField,    "NumReps"},
+    {"previousAuctions", offsetof(Bid, previousAuctions), intField,    "PreviousAuctions"},
+    {"previousCancels",  offsetof(Bid, previousCancels),  intField,    "PreviousCancels"},
+    {"auctionID",        offsetof(Bid, auctionID),        intField,    "AuctionID"}
+};
+const int numBidFields = sizeof(bidFields) / sizeof(bidFields[0]);
 
 
 // Implement function to import bid selection parameters
-BidSelectionParams getBidSelectionParams(){
+BidSelectionParams getBidSelectionParams(SelectionModel model){
 
     ifstream infile("coeff.txt");
     string line;
@@ -64,141 +58,255 @@ BidSelectionParams getBidSelectionParams(){
         nlogitParams.push_back( atof(readParam.c_str()) );
     }
 
-    // Unpack the vector into the parameter object
-    BidSelectionParams nestedLogitParams;
-    nestedLogitParams.bidAmountCoeff = nlogitParams[0];
-    nestedLogitParams.sellRepCoeff = nlogitParams[1];
-    nestedLogitParams.nestConstant = nlogitParams[5];
-    nestedLogitParams.lnnumrepsCoeff = nlogitParams[2];
-    nestedLogitParams.buyrepCoeff = nlogitParams[3];
-    nestedLogitParams.lnprevcancelCoeff = nlogitParams[4];
-    nestedLogitParams.nestCorr = nlogitParams[7];
+    // Unpack the vector into the parameter object, in the model's layout.  The struct is zeroed
+    // first so that its padding is too, since checkpoints fingerprint its bytes.
+    BidSelectionParams selectionParams;
+    memset(&selectionParams, 0, sizeof(selectionParams));
+    selectionParams.model = model;
+    switch( model ){
+    case multinomialLogitModel:
+        MultinomialLogitModel::readCoefficients(nlogitParams, selectionParams);
+        break;
+    default:
+        NestedLogitModel::readCoefficients(nlogitParams, selectionParams);
+        break;
+    }
 
     // Debugging: read out values
-    // cout << "bidAmount: " << nestedLogitParams.bidAmountCoeff << "\n";
-    // cout << "sellRep: " << nestedLogitParams.sellRepCoeff << "\n";
-    // cout << "nestConstant: " << nestedLogitParams.nestConstant << "\n";
-    // cout << "lnnumreps: " << nestedLogitParams.lnnumrepsCoeff << "\n";
-    // cout << "buyrep: " << nestedLogitParams.buyrepCoeff << "\n";
-    // cout << "lnprevcancel: " << nestedLogitParams.lnprevcancelCoeff << "\n";
-    // cout << "nestCorr: " << nestedLogitParams.nestCorr << "\n";
+    // cout << "bidAmount: " << selectionParams.bidAmountCoeff << "\n";
+    // cout << "sellRep: " << selectionParams.sellRepCoeff << "\n";
+    // cout << "nestConstant: " << selectionParams.nestConstant << "\n";
+    // cout << "lnnumreps: " << selectionParams.lnnumrepsCoeff << "\n";
+    // cout << "buyrep: " << selectionParams.buyrepCoeff << "\n";
+    // cout << "lnprevcancel: " << selectionParams.lnprevcancelCoeff << "\n";
+    // cout << "nestCorr: " << selectionParams.nestCorr << "\n";
     
-    return( nestedLogitParams );
+    return( selectionParams );
 }
 
 
 
-// Implement function to simulate an auction
-pair<double, double> simulateAuction(Bid currentBid, int uAucType, int numBidderTypes,
-                                     vector< vector< vector< vector<Bid> > > >& sampleBids,
-                                     BidSelectionParams& bidSelParams,
-                                     vector< vector<double> > bidderTypeCumDist,
-                                     vector< vector<double> > numBidCumDist){
+//// Simulation functions, written once as templates on the selection model (a policy from
+//// selection_models.hpp) and instantiated for each model by the functions at the end of the file
 
+// Implement function to simulate a batch of auctions
+template<class Model>
+static SimulationSums simulateAuctionsWith(const Bid& currentBid, int uAucType,
+                                           const CompetitorDraws& competitorDraws, int firstSim, int numSims,
+                                           const SampleBidStore& sampleBids,
+                                           const BidSelectionParams& bidSelParams,
+                                           AuctionScratch& scratch){
 
-    // Draw a random number of other bidders
-    double otherBidderIndex = (double)(random() % 1000) / 1000;
-    int numOtherBids = 0;
-    // Idea: while condition is true if numOtherBids should be greater than one.  In thise case,
-    // we add one and exit the loop with the proper number.
-    while( otherBidderIndex >= numBidCumDist[currentBid.obsAucType - 1][0] ){
-        numOtherBids++;
-        if( otherBidderIndex < numBidCumDist[currentBid.obsAucType - 1][numOtherBids] ){
-            break;
-        }
-    }
-    // Increase numOtherBids by one since indexing starts at 0
-    numOtherBids++;
-    //cout << "Random draw index " << otherBidderIndex << ".  " << numOtherBids << " other bids\n";
-    
-    //cout << "Starting bid: " << currentBid.amount << "; type " << currentBid.bidderType << ", " << currentBid.state[0] << "\n";
+    //// Terms that are the same in every simulation of this bid
+
+    // Observed auction type (indexed from 0), which picks the sample bid cells
+    int obsAucType = currentBid.obsAucType - 1;
+
+    // Focal bid terms, and the coefficients of competitor utilities
+    FocalBidTerms focal = Model::focalTerms(currentBid, bidSelParams);
+    CompetitorCoeffs coeffs = Model::competitorCoeffs(bidSelParams);
 
+    // Competitor utilities are written to the caller's scratch space
+    double *utilities = scratch.utilities.data();
+    int *numOtherBids = scratch.numOtherBids.data();
 
-    // For all other bids, draw a random bidder type
-    int bidTypes[numOtherBids + 1];
-    int simBidderType;
-    double bidderTypeIndex;
-    for(int i = 1; i < numOtherBids + 1; i++){
 
-        // Reset bidder type for new index
-        simBidderType = 0;
+    //// Simulate the auctions in blocks of simBlockSize, one auction per SIMD lane
 
-        // Draw a new random value
-        bidderTypeIndex = (double)(random() % 1000) / 1000;
+    SimulationSums sums = {0, 0, 0, 0, 0};
+    for(int blockStart = firstSim; blockStart < firstSim + numSims; blockStart += simBlockSize){
 
-        // Find the bidder type corresponding to the random value
-        while( bidderTypeIndex >= bidderTypeCumDist[currentBid.obsAucType - 1][0] ){
-            simBidderType++;
-            if( bidderTypeIndex < bidderTypeCumDist[currentBid.obsAucType - 1][simBidderType] ){
-                break;
+        int blockSims = min(simBlockSize, firstSim + numSims - blockStart);
+        int blockMaxOtherBids = 0;
+
+        for(int lane = 0; lane < blockSims; lane++){
+
+            // Look up the amounts of this auction's competitors in the sample for this observed
+            // auction type, unobserved auction type, and their bidder types, and calculate their
+            // utilities using the selection model's coefficients
+            int sim = blockStart + lane;
+            const int *bidTypes = competitorDraws.bidTypes(sim);
+            const int *rows = competitorDraws.rows(sim);
+            numOtherBids[lane] = competitorDraws.numOtherBids(sim);
+            blockMaxOtherBids = max(blockMaxOtherBids, numOtherBids[lane]);
+            for(int i = 0; i < numOtherBids[lane]; i++){
+                int cell = sampleBids.cellIndex(bidTypes[i], obsAucType, uAucType);
+                double bidAmount = sampleBids.amount(cell, rows[i]);
+                utilities[i*simBlockSize + lane] = coeffs.amountCoeff*bidAmount + coeffs.sellRepCoeff*bidTypes[i];
             }
         }
-        //cout << "Random draw index " << bidderTypeIndex << ".  " << simBidderType++ << " bidder type\n";
-        bidTypes[i] = simBidderType + 1; // Adjust for index starting at 0
+        // Unused lanes of a partial block have no competitors
+        for(int lane = blockSims; lane < simBlockSize; lane++){
+            numOtherBids[lane] = 0;
+        }
+
+        // Selection probabilities and derivatives for the whole block
+        Model::evaluate(utilities, numOtherBids, blockSims, blockMaxOtherBids, focal, sums);
     }
-    // The first bidType is given by currentBid
-    bidTypes[0] = currentBid.bidderType - 1; // Subtract 1 to adjust for indexing that starts at 0
 
-    
+    // printf("probSum: %lf. probDerSum: %lf.\n", sums.probSum, sums.probDerSum);
+    return( sums );
+}
 
-    // Draw numOtherBids random bids from the sample for this observed auction type and the relevant bidder type
-    // Each draw is from {0, ..., 9999}
-    Bid bids[numOtherBids + 1];
-    bids[0] = currentBid;
-    for(int i = 1; i < numOtherBids + 1; i++){
-        bidTypes[i] = random() % numBidderTypes;
-        bids[i] = sampleBids[bidTypes[i]][currentBid.obsAucType - 1][uAucType][random() % 10000];
 
-        // Fill in the auction-specific parts of the bid (memcpy needed to assign the array)
-        memcpy(bids[i].state, currentBid.state, sizeof(currentBid.state));
 
-        // cout << uAucType << "; " << bidTypes[i] << "; " << bids[i] << "\n";
+// Implement function to find the inclusive value of one simulated auction's competitors: the log of
+// the sum of exp(utility / nestCorr) over the other bids, shifted by the largest utility so that the
+// sum can't overflow
+template<class Model>
+static double competitorLogExpSumWith(const CompetitorDraws& competitorDraws, int sim, int obsAucType, int uAucType,
+                                      const SampleBidStore& sampleBids, const BidSelectionParams& bidSelParams){
+
+    CompetitorCoeffs coeffs = Model::competitorCoeffs(bidSelParams);
+    double amountCoeff = coeffs.amountCoeff;
+    double sellRepCoeff = coeffs.sellRepCoeff;
+    const int *bidTypes = competitorDraws.bidTypes(sim);
+    const int *rows = competitorDraws.rows(sim);
+    int numOtherBids = competitorDraws.numOtherBids(sim);
+
+    double maxUtil = -INFINITY;
+    for(int i = 0; i < numOtherBids; i++){
+        int cell = sampleBids.cellIndex(bidTypes[i], obsAucType, uAucType);
+        maxUtil = max(maxUtil, amountCoeff*sampleBids.amount(cell, rows[i]) + sellRepCoeff*bidTypes[i]);
+    }
+    double expSum = 0;
+    for(int i = 0; i < numOtherBids; i++){
+        int cell = sampleBids.cellIndex(bidTypes[i], obsAucType, uAucType);
+        expSum += exp(amountCoeff*sampleBids.amount(cell, rows[i]) + sellRepCoeff*bidTypes[i] - maxUtil);
     }
+    return( maxUtil + log(expSum) );
+}
 
 
-    // DEBUGGING: set bids and bid types
-    // double bids[numOtherBids + 1] = {321, 246.528, 218.8331, 261.0508, 250.574, 257.6782, 200.9693, 264.1822, 261.9003, 185.5633};
-    // int bidTypes[numOtherBids + 1] = {2, 2, 0, 2, 0, 1, 1, 2, 2, 0};
+// Implement function to evaluate a bid against a list of competitor inclusive values
+// All competitors of an auction together act like one competitor whose utility is their inclusive
+// value, so each value fills one lane of the kernel as a single competitor
+template<class Model>
+static SimulationSums evaluateInclusiveValuesWith(const Bid& currentBid, const double *logExpSums, int numValues,
+                                                  const BidSelectionParams& bidSelParams, AuctionScratch& scratch){
 
-    
-    // Use simulated auction for utility calculations to get probability and its derivative
-    // Calculate the utility of each bid using the nested logit parameters
-    double utilities[numOtherBids + 1];
-    for(int i = 0; i < numOtherBids + 1; i++){
-        utilities[i] = (bidSelParams.bidAmountCoeff*bids[i] + bidSelParams.sellRepCoeff*bidTypes[i])
-            / bidSelParams.nestCorr;
-        // Entry 1: c6_price; entry 2: c6_sellrep; entry 8: nestCorr        
+    FocalBidTerms focal = Model::focalTerms(currentBid, bidSelParams);
+    double *utilities = scratch.utilities.data();
+    int *numOtherBids = scratch.numOtherBids.data();
+
+    SimulationSums sums = {0, 0, 0, 0, 0};
+    for(int blockStart = 0; blockStart < numValues; blockStart += simBlockSize){
+        int blockValues = min(simBlockSize, numValues - blockStart);
+        for(int lane = 0; lane < simBlockSize; lane++){
+            utilities[lane] = (lane < blockValues ? logExpSums[blockStart + lane] : 0);
+            numOtherBids[lane] = (lane < blockValues ? 1 : 0);
+        }
+        Model::evaluate(utilities, numOtherBids, blockValues, 1, focal, sums);
     }
+    return( sums );
+}
+
 
+// Implement function to evaluate many bids against one shared list of inclusive values
+// The values are processed in tiles small enough to stay in the L1 cache while every bid passes
+// over them, like the blocked loops of a matrix product: each tile is read from memory once rather
+// than once per bid.  Each bid's focal terms are computed once.
+template<class Model>
+static void evaluateBidsAgainstInclusiveValuesWith(const Bid *const *bids, int numBids, const double *logExpSums,
+                                                   int numValues, const BidSelectionParams& bidSelParams,
+                                                   SimulationSums *sums){
 
-    // Account for the fact that numReps might be zero
-    double buyRepVal = (currentBid.numReps > 0 ? (currentBid.sumRep / currentBid.numReps) : 0);
-    double nestUtil = bidSelParams.nestConstant + bidSelParams.lnnumrepsCoeff*log(currentBid.numReps + 1) +
-        bidSelParams.buyrepCoeff*buyRepVal + bidSelParams.lnprevcancelCoeff*log(currentBid.previousCancels + 1);
-    // Entry 6: c7_cons; entry 3: c7_lnnumreps; entry 4: c7_buyrep; entry 5: lnprevcancel
+    // Values per tile (32 KB of doubles), a multiple of simBlockSize
+    const int tileValues = 4096;
 
-    // Traverse the array to add exp(utility) and find the max
-    double expUtilSum = exp(utilities[0]);
-    for(int i = 1; i < numOtherBids + 1; i++){
-        expUtilSum += exp( utilities[i] );
+    vector<FocalBidTerms> focal(numBids);
+    for(int n = 0; n < numBids; n++){
+        focal[n] = Model::focalTerms(*bids[n], bidSelParams);
+        SimulationSums zero = {0, 0, 0, 0, 0};
+        sums[n] = zero;
+    }
+    // Every lane holds one auction with a single competitor: its inclusive value
+    int numOtherBids[simBlockSize];
+    for(int lane = 0; lane < simBlockSize; lane++){
+        numOtherBids[lane] = 1;
     }
-    double incVal = log( expUtilSum );
 
-    // cout << "nestUtil: " << nestUtil << "; incVal: " << incVal << "; expUtilSum: " << expUtilSum << "\n";
-    // cout << "utilities[0]: " << utilities[0] << "\n";
-    
-    double A = exp(nestUtil + bidSelParams.nestCorr*incVal);
-    double B = exp(utilities[0]);
-    double C = expUtilSum;
+    for(int tileStart = 0; tileStart < numValues; tileStart += tileValues){
+        int tileEnd = min(tileStart + tileValues, numValues);
+        for(int n = 0; n < numBids; n++){
+            for(int blockStart = tileStart; blockStart < tileEnd; blockStart += simBlockSize){
+                int blockValues = min(simBlockSize, tileEnd - blockStart);
+                Model::evaluate(logExpSums + blockStart, numOtherBids, blockValues, 1, focal[n], sums[n]);
+            }
+        }
+    }
+}
 
-    // printf("A: %lf. B: %lf. C: %lf.\n", A, B, C);
 
-    // First entry is selection probability; second is its derivative
-    pair<double, double> auctionResult;
-    auctionResult.first = A/(1+A) * B/C;
-    auctionResult.second = (  auctionResult.first * bidSelParams.bidAmountCoeff * (B/(C*(1+A)) + 1/bidSelParams.nestCorr*(1 - B/C)) );
-    
-    // printf("prob: %lf. probDer: %lf.\n", auctionResult.first, auctionResult.second);
-    return( auctionResult );
+//// The functions declared in bid_selection.hpp: each calls the copy of its template for the model
+//// in bidSelParams.  Add a case to each switch when adding a model.
+
+SimulationSums simulateAuctions(const Bid& currentBid, int uAucType,
+                                const CompetitorDraws& competitorDraws, int firstSim, int numSims,
+                                const SampleBidStore& sampleBids,
+                                const BidSelectionParams& bidSelParams,
+                                AuctionScratch& scratch){
+    switch( bidSelParams.model ){
+    case multinomialLogitModel:
+        return( simulateAuctionsWith<MultinomialLogitModel>(currentBid, uAucType, competitorDraws, firstSim, numSims,
+                                                            sampleBids, bidSelParams, scratch) );
+    default:
+        return( simulateAuctionsWith<NestedLogitModel>(currentBid, uAucType, competitorDraws, firstSim, numSims,
+                                                       sampleBids, bidSelParams, scratch) );
+    }
+}
+
+double competitorLogExpSum(const CompetitorDraws& competitorDraws, int sim, int obsAucType, int uAucType,
+                           const SampleBidStore& sampleBids, const BidSelectionParams& bidSelParams){
+    switch( bidSelParams.model ){
+    case multinomialLogitModel:
+        return( competitorLogExpSumWith<MultinomialLogitModel>(competitorDraws, sim, obsAucType, uAucType,
+                                                               sampleBids, bidSelParams) );
+    default:
+        return( competitorLogExpSumWith<NestedLogitModel>(competitorDraws, sim, obsAucType, uAucType,
+                                                          sampleBids, bidSelParams) );
+    }
+}
+
+SimulationSums evaluateInclusiveValues(const Bid& currentBid, const double *logExpSums, int numValues,
+                                       const BidSelectionParams& bidSelParams, AuctionScratch& scratch){
+    switch( bidSelParams.model ){
+    case multinomialLogitModel:
+        return( evaluateInclusiveValuesWith<MultinomialLogitModel>(currentBid, logExpSums, numValues, bidSelParams,
+                                                                   scratch) );
+    default:
+        return( evaluateInclusiveValuesWith<NestedLogitModel>(currentBid, logExpSums, numValues, bidSelParams,
+                                                              scratch) );
+    }
+}
+
+void evaluateBidsAgainstInclusiveValues(const Bid *const *bids, int numBids, const double *logExpSums,
+                                        int numValues, const BidSelectionParams& bidSelParams,
+                                        SimulationSums *sums){
+    switch( bidSelParams.model ){
+    case multinomialLogitModel:
+        evaluateBidsAgainstInclusiveValuesWith<MultinomialLogitModel>(bids, numBids, logExpSums, numValues,
+                                                                      bidSelParams, sums);
+        break;
+    default:
+        evaluateBidsAgainstInclusiveValuesWith<NestedLogitModel>(bids, numBids, logExpSums, numValues,
+                                                                 bidSelParams, sums);
+        break;
+    }
+}
+
+// The fields read by simulateAuctions(): amount, bidderType, obsAucType, sumRep, numReps, and
+// previousCancels (previousAuctions is not part of the selection model)
+size_t SelectionInputHash::operator()(const Bid& bid) const {
+    // Hash -0.0 like 0.0, since they compare equal
+    double amount = (bid.amount == 0 ? 0.0 : bid.amount);
+    int fields[5] = {bid.bidderType, bid.obsAucType, bid.sumRep, bid.numReps, bid.previousCancels};
+    uint64_t hash = hashBytes(&amount, sizeof(amount), fnvOffsetBasis);
+    hash = hashBytes(fields, sizeof(fields), hash);
+    return( hash );
+}
 
+bool SameSelectionInputs::operator()(const Bid& a, const Bid& b) const {
+    return( (a.amount == b.amount) && (a.bidderType == b.bidderType) && (a.obsAucType == b.obsAucType) &&
+            (a.sumRep == b.sumRep) && (a.numReps == b.numReps) && (a.previousCancels == b.previousCancels) );
 }
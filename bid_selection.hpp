@@ -9,6 +9,7 @@
 
 // For convenience, load all necessary libraries here
 #include <stdio.h>
+#include <stddef.h> // For offsetof()
 #include <iostream> // for cout
 #include <math.h>
 #include <stdlib.h>
@@ -19,6 +20,11 @@
 #include <algorithm> // to count character occurrences in string: std::count() (also for some string methods)
 #include <vector> // For vector class
 #include <numeric> // For accumulate()
+#include <thread> // For std::thread, used to simulate bids in parallel
+#include <atomic> // For std::atomic, used to hand out bids to threads
+#include "random_streams.hpp" // For RandomStream, the counter-based random number generator
+#include "alias_table.hpp" // For AliasTable, used to draw bidder types and numbers of bidders
+#include "competitor_draws.hpp" // For CompetitorDraws, the simulated competitors of each auction
 
 // Declarations
 // Note that the standard namespace isn't (and shouldn't) be used in the header file, so some data
@@ -33,10 +39,23 @@ typedef struct {
     int previousAuctions;
     int previousCancels;
     int obsAucType;
-    bool isLastBid; // Tells if this bid is the last one in the file
+    int auctionID;
 } Bid;
 
-// Bid selection model coefficient data type
+// A field of Bid that is read from the bid data: its name in the column mapping file, where it is in
+// Bid, its type, and the column of template_data.csv that fills it unless the mapping says otherwise
+enum BidFieldType { intField, doubleField };
+typedef struct {
+    const char *name;
+    size_t offset;
+    BidFieldType type;
+    const char *defaultColumn;
+} BidField;
+
+// Bid selection models, each implemented by a policy in selection_models.hpp
+enum SelectionModel { nestedLogitModel, multinomialLogitModel };
+
+// Bid selection model coefficient data type (nestCorr is 1 in the multinomial logit)
 typedef struct {
     double bidAmountCoeff;
     double sellRepCoeff;
@@ -45,10 +64,11 @@ typedef struct {
     double lnnumrepsCoeff;
     double buyrepCoeff;
     double lnprevcancelCoeff;
+    SelectionModel model;
 } BidSelectionParams;
 
 // Auction traits class storing the number of types used in the auction
-// (Inferred from data files in getAucTraits() at runtime.)
+// (Read from the sample bid manifest at runtime; see import_data.hpp.)
 typedef struct {
     int numBidderTypes;
     int numObsAucTypes;
@@ -56,23 +76,112 @@ typedef struct {
 } AucTraits;
 
 
-// Function to import bid data from each row of a file
-Bid getBidData(std::FILE *bidFile);
+// Fields of Bid read from the bid data (defined in bid_selection.cpp; loaded by loadBidData(),
+// declared in bid_data_loader.hpp)
+extern const BidField bidFields[];
+extern const int numBidFields;
+
+// Function to import bid selection model parameters from coeff.txt, in the layout of the given model
+BidSelectionParams getBidSelectionParams(SelectionModel model = nestedLogitModel);
+
+// Functions to import the sample bids and distributions of bidder types and numbers of bidders
+// are declared in import_data.hpp
+
+// Sample bid storage, declared in sample_bid_store.hpp
+class SampleBidStore;
+
+// Running sums of the simulated selection probability and its derivative over a batch of
+// simulated auctions for one bid, with the squares and cross product used for standard errors
+typedef struct {
+    double probSum;
+    double probDerSum;
+    double probSqSum;
+    double probDerSqSum;
+    double probCrossSum;
+} SimulationSums;
+
+// Simulation outcomes for one bid and unobserved auction type, as written to estimated_costs.csv
+typedef struct {
+    double prob;     // mean selection probability
+    double probDer;  // mean derivative of the probability with respect to the bid amount
+    double cost;     // implied cost
+    int numSims;     // number of simulated auctions behind the means
+    double costSE;   // delta-method standard error of the cost
+} SimulationResult;
+
+// Number of simulated auctions evaluated together by the kernels in nested_logit_kernel.cpp
+// (the widest vector holds eight doubles)
+const int simBlockSize = 8;
+
+// Scratch space for the competitors in a block of simulated auctions
+// Owned by the caller (one per thread) and reused for every batch, so that simulating auctions
+// never allocates memory.  Sized for the largest auction in the number-of-bids distribution.
+// Utilities are stored competitor by competitor, with the auctions of a block side by side, so
+// that the vectorized kernel in nested_logit_kernel.cpp can evaluate one auction per SIMD lane.
+class AuctionScratch {
+
+public:
+
+    AuctionScratch(const std::vector<AliasTable>& numBidDist){
+        maxOtherBids = 0;
+        for(size_t i = 0; i < numBidDist.size(); i++){
+            maxOtherBids = std::max(maxOtherBids, numBidDist[i].size());
+        }
+        utilities.resize(maxOtherBids * simBlockSize);
+        numOtherBids.resize(simBlockSize);
+    }
+
+    int maxOtherBids;
+    std::vector<double> utilities;
+    std::vector<int> numOtherBids;
+};
+
+// Function to simulate a batch of auctions for one bid
+// Evaluates the bid in unobserved auction type uAucType against the competitors of simulations
+// firstSim, ..., firstSim + numSims - 1 in the bank competitorDraws, and returns the summed
+// probabilities and derivatives.  Terms that only depend on the bid are computed once per batch,
+// and the auctions are evaluated in blocks by the vectorized kernel.  All inputs other than the
+// scratch space are read-only, so a single copy of the sample bids and draws can be shared by
+// every thread.
+SimulationSums simulateAuctions(const Bid& currentBid, int uAucType,
+                                const CompetitorDraws& competitorDraws, int firstSim, int numSims,
+                                const SampleBidStore& sampleBids,
+                                const BidSelectionParams& bidSelParams,
+                                AuctionScratch& scratch);
+
+
+// Function to find the inclusive value of the competitors of simulation sim in a bank: the log of
+// the sum of exp(utility / nestCorr) over the other bids in the given auction types (indexed from 0).
+// Competitors only enter the selection probability through this value, which doesn't depend on
+// the focal bid.
+double competitorLogExpSum(const CompetitorDraws& competitorDraws, int sim, int obsAucType, int uAucType,
+                           const SampleBidStore& sampleBids, const BidSelectionParams& bidSelParams);
+
+// Function to evaluate a bid against numValues competitor inclusive values (as returned by
+// competitorLogExpSum()), returning the summed probabilities and derivatives as simulateAuctions()
+// would for auctions with those competitors
+SimulationSums evaluateInclusiveValues(const Bid& currentBid, const double *logExpSums, int numValues,
+                                       const BidSelectionParams& bidSelParams, AuctionScratch& scratch);
+
 
-// Function to import bid selection model parameters
-BidSelectionParams getBidSelectionParams();
+// Function to evaluate numBids bids, all in the same unobserved auction type, against the same
+// numValues inclusive values, writing the summed probabilities and derivatives of bids[n] to
+// sums[n].  logExpSums must have room for numValues rounded up to a multiple of simBlockSize (the
+// padding is read but ignored).
+void evaluateBidsAgainstInclusiveValues(const Bid *const *bids, int numBids, const double *logExpSums,
+                                        int numValues, const BidSelectionParams& bidSelParams,
+                                        SimulationSums *sums);
 
-// Function to import distribution of bidder types
-std::vector< std::vector<double> > importBidderTypeDist(AucTraits aucTraits);
-// Function to import distribution of number of bidders
-std::vector< std::vector<double> > importNumBidDist(AucTraits aucTraits);
 
-// Function to simulate an auction
-std::pair<double, double> simulateAuction(Bid currentBid, int uAucType, int numBidderTypes,
-                                          std::vector< std::vector< std::vector< std::vector<Bid> > > >& sampleBids,
-                                          BidSelectionParams& bidSelParams,
-                                          std::vector< std::vector<double> > bidderTypeCumDist,
-                                          std::vector< std::vector<double> > numBidCumDist);
+// Hash and equality on exactly the fields of Bid that simulateAuctions() reads, so that bids with
+// equal simulation inputs can share one set of simulations.  Update both when simulateAuctions()
+// starts reading another field.
+struct SelectionInputHash {
+    size_t operator()(const Bid& bid) const;
+};
+struct SameSelectionInputs {
+    bool operator()(const Bid& a, const Bid& b) const;
+};
 
 
 // End header guard with endif statement
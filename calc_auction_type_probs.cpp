@@ -0,0 +1,143 @@
+// calc_auction_type_probs.cpp
+// Estimate the probability that each auction is of each unobserved auction type, replacing
+// calc_auction_type_probs.m (see auction_type_probs.hpp).  Writes unobs_auc_type_probs.csv,
+// num_bid_distribution.csv, and bidder_type_distribution.csv in the same formats as the MATLAB code.
+// Compiled as: g++ -O2 -pthread -o calc_auction_type_probs.exe calc_auction_type_probs.cpp auction_type_probs.cpp weighted_kde.cpp bid_data_loader.cpp bid_selection.cpp alias_table.cpp competitor_draws.cpp sobol_sequence.cpp nested_logit_kernel.cpp
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "bid_data_loader.hpp"
+#include "auction_type_probs.hpp"
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+// Command line options:
+//   --types K            unobserved auction types to estimate (required; the argument of
+//                        calc_auction_type_probs.m)
+//   --data FILE          bid data (default energysage_data_to_estimate.csv, as in the MATLAB code)
+//   --bid-columns FILE   column mapping of the bid data (default bid_columns.txt; see bid_data_loader.hpp)
+//   --threads N          threads to use (default 1; 0 uses every available core)
+//   --tolerance X        stop once the convergence criterion is at most X (default 1e-6)
+//   --max-iterations N   give up after N iterations (default 10000)
+//   --kde-bins G         nodes of the grid the bid densities are binned on (default 16384)
+int main(int argc, char *argv[]){
+
+    // Read command line options
+    TypeProbSettings settings;
+    settings.numUnobsAucTypes = 0;
+    settings.numPoints = 100;
+    settings.bandwidth = 0.1;
+    settings.lowProb = 0.000001;
+    settings.kdeBins = 16384;
+    settings.tolerance = 0.000001;
+    settings.maxIterations = 10000;
+    const char *dataFile = "energysage_data_to_estimate.csv";
+    const char *bidColumnsFile = "bid_columns.txt";
+    int numThreads = 1;
+    for(int i = 1; i < argc; i++){
+        if( (strcmp(argv[i], "--types") == 0) && (i + 1 < argc) ){
+            settings.numUnobsAucTypes = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--data") == 0) && (i + 1 < argc) ){
+            dataFile = argv[++i];
+        } else if( (strcmp(argv[i], "--bid-columns") == 0) && (i + 1 < argc) ){
+            bidColumnsFile = argv[++i];
+        } else if( (strcmp(argv[i], "--threads") == 0) && (i + 1 < argc) ){
+            numThreads = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--tolerance") == 0) && (i + 1 < argc) ){
+            settings.tolerance = atof(argv[++i]);
+        } else if( (strcmp(argv[i], "--max-iterations") == 0) && (i + 1 < argc) ){
+            settings.maxIterations = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--kde-bins") == 0) && (i + 1 < argc) ){
+            settings.kdeBins = atoi(argv[++i]);
+        } else {
+            cout << "Error: unrecognized option " << argv[i] << ".\n";
+            cout << "Usage: calc_auction_type_probs.exe --types K [--data FILE] [--bid-columns FILE]"
+                 << " [--threads N] [--tolerance X] [--max-iterations N] [--kde-bins G]\n";
+            return(1);
+        }
+    }
+    if( settings.numUnobsAucTypes <= 0 ){
+        cout << "Error: --types must be given and greater than zero.\n";
+        return(1);
+    }
+    if( !(settings.tolerance > 0) || (settings.maxIterations <= 0) || (settings.kdeBins < 2) ){
+        cout << "Error: --tolerance and --max-iterations must be positive, and --kde-bins at least 2.\n";
+        return(1);
+    }
+    if( numThreads <= 0 ){
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+
+
+    //// Part 1: Import data
+
+    vector<Bid> bids;
+    if( !loadBidData(dataFile, bidColumnsFile, numThreads, bids) ){
+        return(1);
+    }
+
+    // Drop outside option bids
+    size_t kept = 0;
+    for(size_t i = 0; i < bids.size(); i++){
+        if( bids[i].bidderType != 0 ){
+            bids[kept++] = bids[i];
+        }
+    }
+    if( kept < bids.size() ){
+        cout << "Removing outside option bids from data...\n";
+        bids.resize(kept);
+    }
+    if( bids.empty() ){
+        cout << "Error: " << dataFile << " has no bids other than the outside option.\n";
+        return(1);
+    }
+
+    // Types are numbered from 1, and the outputs have a row or column for each up to the largest
+    AucTraits aucTraits;
+    aucTraits.numBidderTypes = 0;
+    aucTraits.numObsAucTypes = 0;
+    aucTraits.numUnobsAucTypes = settings.numUnobsAucTypes;
+    for(size_t i = 0; i < bids.size(); i++){
+        if( (bids[i].bidderType < 1) || (bids[i].obsAucType < 1) ){
+            cout << "Error: bid " << i + 1 << " (after removing the outside option) has bidder type "
+                 << bids[i].bidderType << " and observed auction type " << bids[i].obsAucType
+                 << "; types must be at least 1.\n";
+            return(1);
+        }
+        aucTraits.numBidderTypes = max(aucTraits.numBidderTypes, bids[i].bidderType);
+        aucTraits.numObsAucTypes = max(aucTraits.numObsAucTypes, bids[i].obsAucType);
+    }
+    AuctionIndex index = indexAuctions(bids);
+
+
+    //// Part 2: Iterate until the type probabilities converge
+
+    vector<double> typeProbs = initialTypeProbs(bids, index, settings.numUnobsAucTypes);
+    vector<double> updatedProbs;
+    double convMetric = 1;
+    int iteration = 0;
+    while( convMetric > settings.tolerance ){
+        if( iteration == settings.maxIterations ){
+            cout << "Error: the type probabilities did not converge in " << settings.maxIterations << " iterations.\n";
+            return(1);
+        }
+        convMetric = iterateTypeProbs(bids, index, aucTraits, settings, typeProbs, numThreads, updatedProbs);
+        typeProbs.swap(updatedProbs);
+        iteration++;
+        printf("Iterations: %d.  Convergence criterion: %5.8f\n", iteration, convMetric);
+    }
+
+
+    //// Part 3: Write the type probabilities and the distributions of the number of bids and the
+    //// bidder types for each observed auction type
+
+    if( !writeTypeProbs("unobs_auc_type_probs.csv", typeProbs, settings.numUnobsAucTypes) ||
+        !writeNumBidDistribution("num_bid_distribution.csv", bids, index, aucTraits) ||
+        !writeBidderTypeDistribution("bidder_type_distribution.csv", bids, index, aucTraits) ){
+        return(1);
+    }
+
+    return 0;
+}
@@ -1,10 +1,21 @@
 // calculate_costs.cpp
 // Simulate auctions for each bid; use the resulting choice probabilities to infer seller costs
-// Compiled as: g++ -o calculate_costs.exe calculate_costs.cpp bid_selection.cpp
+// Compiled as: g++ -O2 -pthread -o calculate_costs.exe calculate_costs.cpp bid_selection.cpp import_data.cpp alias_table.cpp sample_bid_store.cpp nested_logit_kernel.cpp competitor_draws.cpp sobol_sequence.cpp bid_data_loader.cpp checkpoint.cpp inclusive_value_table.cpp run_report.cpp cost_shards.cpp sample_bid_generator.cpp weighted_kde.cpp cost_bootstrap.cpp auction_type_probs.cpp
 // Drew Vollmer 2017-12-22
 
 // Libraries imported in bid_selection.hpp
 #include "bid_selection.hpp"
+#include "import_data.hpp"
+#include "bid_data_loader.hpp"
+#include "checkpoint.hpp"
+#include "inclusive_value_table.hpp"
+#include "run_report.hpp"
+#include "cost_shards.hpp"
+#include "sample_bid_generator.hpp"
+#include "cost_bootstrap.hpp"
+#include <chrono> // For the time between checkpoints
+#include <unordered_map> // For matching bids with the same simulation inputs
+#include "nested_logit_kernel.hpp"
 
 // Use standard namespace: can call cout and vector rather than std::cout and std::vector
 using namespace std;
@@ -21,196 +32,632 @@ using namespace std;
 
 //// Functions to import data
 
-// Get number of bidder types and auction types in the data
-AucTraits getAucTraits(){
+// Contained in import_data.cpp
 
-    // Declare variable to return
-    AucTraits aucTraits;
 
-    // Assuming CDFs are in files of the form "inv_cdf_bid[0-9]_obsat[0-9].csv", find the number of bidders
-    // and thus the number of files to import. (CDF files are for pairs of bidder types and observed auction types.)
-    int numBidderTypes = 0;
-    char fileName[50];
-    size_t numCols;
+// Settings for the simulations, read from the command line
+typedef struct {
+    int numAucSims;              // simulated auctions per bid and unobserved auction type
+    uint64_t seed;               // seed for the random streams
+    CommonDrawMode commonDraws;  // which simulations share their competitor draws
+    bool adaptive;               // simulate until the cost's standard error reaches costTolerance
+    double costTolerance;        // target standard error of the implied cost (adaptive only)
+    int minSims;                 // first batch, and each later batch, of simulations (adaptive only)
+    int maxSims;                 // most simulations for any bid and auction type (adaptive only)
+    DrawMode drawMode;           // pseudo-random, Sobol, or antithetic uniforms
+    const SobolSequence *sobol;  // Sobol sequence shared by every thread (Sobol draws only)
+    bool memoize;                // bids with the same simulation inputs share one set of simulations
+    double amountGrid;           // if positive, round bid amounts to multiples of this before matching
+    int tableSize;               // if positive, evaluate bids against inclusive value tables of this size
+    int tableDraws;              // simulated auctions behind each inclusive value table
+    const InclusiveValueTable *ivTable; // the tables, shared by every thread (table mode only)
+    bool batched;                // evaluate all bids of a cell against one shared bank at once
+} SimulationSettings;
 
-    // Strategy: count the files that exist and break after the first file that does not exist
-    while(true){
-        sprintf(fileName, "sample_bids_btype_%d_oauctype_1_uauctype_1.csv", numBidderTypes + 1);
-        ifstream infile(fileName);
-        if( infile.good() ){
-            // Increase number of files found
-            numBidderTypes++;
-        } else {
-            break;
-        }
+// Stream type used for the competitor draws shared by every bid of an observed auction type.  These
+// streams are keyed by (seed, observed auction type, sharedDrawStream, simulation index).
+const uint32_t sharedDrawStream = 0xFFFFFFFF;
+
+// File holding the checkpoints of a run, removed once estimated_costs.csv is written (a shard's
+// checkpoint and output are named after the shard instead; see cost_shards.hpp)
+const char *checkpointFile = "estimated_costs.ckpt";
+
+
+// Add the sums from a batch of simulations to a running total
+void addSimulationSums(SimulationSums& total, const SimulationSums& batch){
+    total.probSum += batch.probSum;
+    total.probDerSum += batch.probDerSum;
+    total.probSqSum += batch.probSqSum;
+    total.probDerSqSum += batch.probDerSqSum;
+    total.probCrossSum += batch.probCrossSum;
+}
+
+// Delta-method standard error of the cost b + P/D, where P and D are the means of numSims simulated
+// probabilities and derivatives.  The gradient of P/D is (1/D, -P/D^2), so
+//   Var(P/D) ~ (Var(p)/D^2 - 2*P*Cov(p, d)/D^3 + P^2*Var(d)/D^4) / numSims
+// with the sample variances and covariance of the simulations.  Returns infinity when the error
+// can't be estimated (fewer than two simulations or a zero derivative).
+double costStandardError(const SimulationSums& sums, int numSims){
+
+    if( (numSims < 2) || (sums.probDerSum == 0) ){
+        return( INFINITY );
     }
+    double P = sums.probSum / numSims;
+    double D = sums.probDerSum / numSims;
+    double varP = (sums.probSqSum - numSims*P*P) / (numSims - 1);
+    double varD = (sums.probDerSqSum - numSims*D*D) / (numSims - 1);
+    double covPD = (sums.probCrossSum - numSims*P*D) / (numSims - 1);
+
+    double variance = (varP/(D*D) - 2*P*covPD/(D*D*D) + P*P*varD/(D*D*D*D)) / numSims;
+    // Rounding can leave a tiny negative variance when the simulations barely vary
+    return( sqrt( max(variance, 0.0) ) );
+}
+
+
+// Simulate every bid assigned to this thread, in all unobserved auction types
+// Threads take the next unclaimed bid from the shared counter nextTask, so fast and slow bids
+// balance out across threads.  Each simulation draws from its own counter-based stream keyed by
+// (seed, bid index, auction type, simulation index), which makes the results the same regardless
+// of which thread runs it or in which order.  With common draws, the auction type (and, across
+// bids, the bid index) is left out of the key.  Results are written into preallocated slots, so
+// rows stay in input order.
+// In adaptive mode each bid and auction type simulates batches of settings.minSims auctions until
+// the standard error of its cost is at most settings.costTolerance or settings.maxSims is reached.
+// Simulation i is the same draw whatever the batch it falls in, so the stopping rule only decides
+// how many of a fixed sequence of simulations are used.
+// Bids that reuse another bid's simulations (canonicalBid[i] != i) and bids already finished (by
+// the run a checkpoint came from) are skipped; every other bid is marked
+// finished once all its auction types are stored, and the thread counts itself out of
+// threadsRunning when it stops.  The work done is added to counters once per bid.
+void simulateBidsWorker(const vector<Bid>& bids, AucTraits aucTraits, SimulationSettings settings,
+                        const SampleBidStore& sampleBids,
+                        const BidSelectionParams& nlp,
+                        const vector<AliasTable>& bidderTypeDist,
+                        const vector<AliasTable>& numBidDist,
+                        const vector<CompetitorDraws>& obsTypeDraws,
+                        const vector<size_t>& canonicalBid,
+                        atomic<size_t>& nextTask,
+                        vector< vector<SimulationResult> >& results,
+                        vector< atomic<char> >& bidFinished,
+                        RunCounters& counters,
+                        atomic<int>& threadsRunning){
+
+    // Simulations in the first batch, and the most for any bid and auction type
+    int firstBatch = (settings.adaptive ? settings.minSims : settings.numAucSims);
+    int maxSims = (settings.adaptive ? settings.maxSims : settings.numAucSims);
+    // Competitor scratch space and draws for this thread, reused for every bid
+    AuctionScratch scratch(numBidDist);
+    CompetitorDraws bidDraws;
+    bidDraws.setDrawMode(settings.drawMode, settings.sobol);
 
-    // After finding the number of bidder types, do the same thing to find the number of observed
-    // auction types and unobserved auction types
-    int numObsAucTypes = 0;
     while(true){
-        sprintf(fileName, "sample_bids_btype_1_oauctype_%d_uauctype_1.csv", numObsAucTypes + 1);
-        ifstream infile(fileName);
-        if( infile.good() ){
-            // Increase number of files found
-            numObsAucTypes++;                
-        } else {
+
+        // Claim the next bid; stop once all have been handed out
+        size_t bidIndex = nextTask.fetch_add(1);
+        if( bidIndex >= bids.size() ){
             break;
         }
-    }
+        if( (canonicalBid[bidIndex] != bidIndex) || bidFinished[bidIndex].load(memory_order_relaxed) ){
+            continue;
+        }
+        const Bid& currentBid = bids[bidIndex];
+        int obsAucType = currentBid.obsAucType - 1;
+        long long bidSims = 0;
+        long long bidCompetitorsDrawn = 0;
+        long long bidExpLogCalls = 0;
 
-    int numUnobsAucTypes = 0;
-    while(true){
-        sprintf(fileName, "sample_bids_btype_1_oauctype_1_uauctype_%d.csv", numUnobsAucTypes + 1);
-        ifstream infile(fileName);
-        if( infile.good() ){
-            // Increase number of files found
-            numUnobsAucTypes++;
-        } else {
-            break;
+        for(int uAucType = 0; uAucType < aucTraits.numUnobsAucTypes; uAucType++){
+
+            // Skip if this is an outside option bid, but insert a placeholder
+            if( currentBid.bidderType == 0 ){
+                SimulationResult placeholder = {-99, -99, -99, -99, -99};
+                results[uAucType][bidIndex] = placeholder;
+                continue;
+            }
+
+            // Competitors for this bid and auction type: shared by the observed auction type,
+            // drawn once for the bid, or drawn for each auction type.  A bid's own bank starts
+            // empty and grows with the batches; with draws shared across types, later types reuse
+            // the simulations drawn for earlier ones and extend the bank only if they need more.
+            const CompetitorDraws *competitorDraws = &bidDraws;
+            uint32_t streamType = (settings.commonDraws == independentDraws ? uAucType : 0);
+            if( settings.commonDraws == commonAcrossBids ){
+                competitorDraws = &obsTypeDraws[obsAucType];
+            } else if( (settings.commonDraws == independentDraws) || (uAucType == 0) ){
+                bidDraws.reset(0);
+            }
+
+            // Simulate results from the current bid in batches, getting the selection probability
+            // and its derivative, until the cost is precise enough or the simulations run out
+            SimulationSums sums = {0, 0, 0, 0, 0};
+            int numSims = 0;
+            int batchSims = firstBatch;
+            double costSE = INFINITY;
+            // With inclusive value tables, the quantiles in the table stand in for the simulations
+            if( settings.ivTable != NULL ){
+                sums = evaluateInclusiveValues(currentBid, settings.ivTable->values(obsAucType, uAucType),
+                                               settings.ivTable->size(), nlp, scratch);
+                numSims = settings.ivTable->size();
+                costSE = costStandardError(sums, numSims);
+                batchSims = 0;
+                bidSims += numSims;
+                bidExpLogCalls += logitExpLogCalls(numSims, numSims);
+            }
+            while( batchSims > 0 ){
+                if( (competitorDraws == &bidDraws) && (bidDraws.numSims() < numSims + batchSims) ){
+                    int firstNew = bidDraws.numSims();
+                    bidDraws.extend(settings.seed, bidIndex, streamType, numSims + batchSims - bidDraws.numSims(),
+                                    numBidDist[obsAucType], bidderTypeDist[obsAucType], sampleBids.numSamples());
+                    bidCompetitorsDrawn += bidDraws.numCompetitors(firstNew, bidDraws.numSims() - firstNew);
+                }
+                addSimulationSums(sums, simulateAuctions(currentBid, uAucType, *competitorDraws, numSims,
+                                                         batchSims, sampleBids, nlp, scratch));
+                bidSims += batchSims;
+                bidExpLogCalls += logitExpLogCalls(batchSims, competitorDraws->numCompetitors(numSims, batchSims));
+                numSims += batchSims;
+                costSE = costStandardError(sums, numSims);
+
+                if( !settings.adaptive || (costSE <= settings.costTolerance) ){
+                    break;
+                }
+                batchSims = min(settings.minSims, maxSims - numSims);
+            }
+            // cout << (sums.probSum / numSims) << "; " << (sums.probDerSum / numSims) << "; " << (sums.probSum / sums.probDerSum) << "\n";
+
+            // Store the averages and calculate the implied cost
+            SimulationResult& result = results[uAucType][bidIndex];
+            result.prob = sums.probSum / numSims;
+            result.probDer = sums.probDerSum / numSims;
+            // Costs need to be multiplied by 1 - commission to be accurate
+            result.cost = currentBid.amount + (sums.probSum / sums.probDerSum);
+            result.numSims = numSims;
+            result.costSE = costSE;
+        }
+
+        // Publish the bid's results to checkpoints, and count the work
+        bidFinished[bidIndex].store(1, memory_order_release);
+        if( currentBid.bidderType != 0 ){
+            counters.simulations.fetch_add(bidSims, memory_order_relaxed);
+            counters.competitorsDrawn.fetch_add(bidCompetitorsDrawn, memory_order_relaxed);
+            counters.expLogCalls.fetch_add(bidExpLogCalls, memory_order_relaxed);
+            counters.bidsProcessed.fetch_add(1, memory_order_relaxed);
         }
     }
-        
-    aucTraits.numBidderTypes = numBidderTypes;
-    aucTraits.numObsAucTypes = numObsAucTypes;
-    aucTraits.numUnobsAucTypes = numUnobsAucTypes;
-    // cout << "Bidder types: " << numBidderTypes << "; Observed auction types: " << numObsAucTypes << "; Unobserved auction types: " << aucTraits.numUnobsAucTypes << "\n";
-    return( aucTraits );
+
+    threadsRunning.fetch_sub(1);
 }
 
 
-// Import sample bids
-// Helper function to import the next bid
-Bid getSampleBid(FILE *sampleBidFile){
+//// Batched evaluation against shared competitor banks
 
-    char line[10000];
-    char *res = fgets(line, sizeof(line), sampleBidFile);
+// Bids evaluated together by one task of the batched engine
+const size_t batchBids = 256;
 
-    // Declare bid object to return and fill with the current line
-    Bid currentBid;
+// One task of the batched engine: bids first, ..., first + count - 1 of the list of bids of an
+// observed auction type, in one unobserved auction type
+typedef struct {
+    int obsAucType;
+    int uAucType;
+    size_t first;
+    size_t count;
+} BatchTask;
 
-    sscanf(line, "%lf, %d, %d, %d, %d, %lf, %lf", &currentBid.amount, &currentBid.bidderType,
-           &currentBid.loanOffered, &currentBid.usPanel, &currentBid.chinesePanel,
-           &currentBid.loanRate, &currentBid.relativeSystemSize);
-    
-    return( currentBid );
+// Evaluate the bids of the tasks claimed from nextTask.  Every bid of an observed auction type
+// faces the same bank of settings.numAucSims simulated auctions, so the competitors of each
+// simulation are reduced once per cell to their inclusive value (cellValues[obsAucType][uAucType])
+// and the batch of bids is evaluated against those values as a dense bids x simulations kernel.
+// This equals the per-bid path with --common-draws bids up to rounding: per bid, that path takes
+// the log-sum-exp of the focal bid and all competitors in one pass, while this one first takes the
+// log-sum-exp of the competitors and then combines it with the focal bid.
+void batchedBidsWorker(const vector<Bid>& bids, const vector< vector<size_t> >& obsTypeBids,
+                       const vector< vector< vector<double> > >& cellValues, const vector<BatchTask>& tasks,
+                       SimulationSettings settings, const BidSelectionParams& nlp, atomic<size_t>& nextTask,
+                       vector< vector<SimulationResult> >& results, RunCounters& counters,
+                       atomic<int>& threadsRunning){
+
+    int numSims = settings.numAucSims;
+    vector<const Bid*> batch;
+    vector<SimulationSums> sums;
+
+    while(true){
+
+        size_t taskIndex = nextTask.fetch_add(1);
+        if( taskIndex >= tasks.size() ){
+            break;
+        }
+        const BatchTask& task = tasks[taskIndex];
+        const vector<size_t>& bidIndices = obsTypeBids[task.obsAucType];
+
+        batch.resize(task.count);
+        sums.resize(task.count);
+        for(size_t n = 0; n < task.count; n++){
+            batch[n] = &bids[ bidIndices[task.first + n] ];
+        }
+        evaluateBidsAgainstInclusiveValues(batch.data(), task.count, cellValues[task.obsAucType][task.uAucType].data(),
+                                           numSims, nlp, sums.data());
+
+        // Store the averages and implied costs, as the per-bid path does
+        for(size_t n = 0; n < task.count; n++){
+            SimulationResult& result = results[task.uAucType][ bidIndices[task.first + n] ];
+            result.prob = sums[n].probSum / numSims;
+            result.probDer = sums[n].probDerSum / numSims;
+            result.cost = batch[n]->amount + (sums[n].probSum / sums[n].probDerSum);
+            result.numSims = numSims;
+            result.costSE = costStandardError(sums[n], numSims);
+        }
+
+        // Each bid is evaluated against one inclusive value per simulation, and counts as processed
+        // with the task for the last unobserved auction type
+        long long taskSims = (long long)task.count * numSims;
+        counters.simulations.fetch_add(taskSims, memory_order_relaxed);
+        counters.expLogCalls.fetch_add(logitExpLogCalls(taskSims, taskSims), memory_order_relaxed);
+        if( task.uAucType == (int)results.size() - 1 ){
+            counters.bidsProcessed.fetch_add(task.count, memory_order_relaxed);
+        }
+    }
+
+    threadsRunning.fetch_sub(1);
 }
-// Note that this function returns void, not the sampleBids vector, because of its size.  Instead,
-// the function returns void and fills in the vector using a reference to its memory address.
-void importSampleBids(vector< vector< vector< vector<Bid> > > >& sampleBids, AucTraits aucTraits){
-
-    // Loop over all files; start by initializing variables used in the loops
-    int lineNum;
-    char fileName[100];
-    string stringToRead;
-    string line;
-    
-    for(int i = 0; i < aucTraits.numBidderTypes; i++){
-        for(int j = 0; j < aucTraits.numObsAucTypes; j++){
-            for(int k = 0; k < aucTraits.numUnobsAucTypes; k++){
 
-                // Get file name using current name indices
-                sprintf(fileName, "sample_bids_btype_%d_oauctype_%d_uauctype_%d.csv",
-                        i + 1, j + 1, k + 1);
-                cout << "Importing file " << fileName << "\n";
+// Set up the batched engine: the inclusive values of every simulation in each cell's bank, the
+// simulated bids of each observed auction type (leaving out those marked in bidDone, which are
+// outside the shard), and the tasks.  Outside option bids get their placeholders here.  The log-sum-exps of the competitors are added to counters.
+void setUpBatches(const vector<Bid>& bids, const vector<size_t>& canonicalBid, const vector<char>& bidDone,
+                  AucTraits aucTraits,
+                  SimulationSettings settings, const vector<CompetitorDraws>& obsTypeDraws,
+                  const SampleBidStore& sampleBids, const BidSelectionParams& nlp,
+                  vector< vector<size_t> >& obsTypeBids, vector< vector< vector<double> > >& cellValues,
+                  vector<BatchTask>& tasks, vector< vector<SimulationResult> >& results, RunCounters& counters){
 
-                // Use ifstream
-                FILE* sampleBidFile = fopen(fileName, "r");
-                char line[10000];
-                char *res = fgets(line, sizeof(line), sampleBidFile); // Header line, which we ignore
+    // Pad the values to whole kernel blocks
+    int numSims = settings.numAucSims;
+    size_t paddedSims = (numSims + simBlockSize - 1) / simBlockSize * simBlockSize;
+    cellValues.assign(aucTraits.numObsAucTypes, vector< vector<double> >(aucTraits.numUnobsAucTypes));
+    for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+        for(int k = 0; k < aucTraits.numUnobsAucTypes; k++){
+            cellValues[j][k].assign(paddedSims, 0);
+            for(int sim = 0; sim < numSims; sim++){
+                cellValues[j][k][sim] = competitorLogExpSum(obsTypeDraws[j], sim, j, k, sampleBids, nlp);
+            }
+            // One exp per competitor and one log per simulation
+            counters.expLogCalls.fetch_add(obsTypeDraws[j].numCompetitors(0, numSims) + numSims);
+        }
+    }
 
-                // Import in a loop
-                for(int row = 0; row < 10000; row++){
-                    sampleBids[i][j][k][row] = getSampleBid(sampleBidFile);
-                }
-                                
-                // Finished processing the current file; next loop iteration handles the next file
+    obsTypeBids.assign(aucTraits.numObsAucTypes, vector<size_t>());
+    for(size_t i = 0; i < bids.size(); i++){
+        if( bids[i].bidderType == 0 ){
+            SimulationResult placeholder = {-99, -99, -99, -99, -99};
+            for(int k = 0; k < aucTraits.numUnobsAucTypes; k++){
+                results[k][i] = placeholder;
             }
+        } else if( (canonicalBid[i] == i) && !bidDone[i] ){
+            obsTypeBids[bids[i].obsAucType - 1].push_back(i);
         }
     }
 
+    tasks.clear();
+    for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+        for(int k = 0; k < aucTraits.numUnobsAucTypes; k++){
+            for(size_t first = 0; first < obsTypeBids[j].size(); first += batchBids){
+                BatchTask task = {j, k, first, min(batchBids, obsTypeBids[j].size() - first)};
+                tasks.push_back(task);
+            }
+        }
+    }
 }
 
-// Import the distribution of bidder types in each observed type of auction
-vector< vector<double> > importBidderTypeDist(AucTraits aucTraits){
 
-    // Open the file and look for aucTraits.numObsAucTypes rows
-    ifstream infile("bidder_type_distribution.csv");
+// Find the bids that can reuse the simulations of an earlier bid.  With settings.amountGrid > 0,
+// amounts in simBids are first rounded to the nearest multiple of the grid.  canonicalBid[i] is then
+// the first bid whose simulation inputs equal those of bid i (i itself if there is none, or if
+// memoization is off).  Taking the first match keeps the choice the same for any number of
+// threads.  Returns the number of bids that have to be simulated.
+size_t findCanonicalBids(SimulationSettings settings, vector<Bid>& simBids, vector<size_t>& canonicalBid){
 
-    // Declare the output array
-    vector<double> emptyVec;
-    vector< vector<double> > bidderTypeDist(aucTraits.numObsAucTypes, emptyVec);
-    vector< vector<double> > bidderTypeCumDist(aucTraits.numObsAucTypes, emptyVec);
+    canonicalBid.resize(simBids.size());
+    if( settings.amountGrid > 0 ){
+        for(size_t i = 0; i < simBids.size(); i++){
+            simBids[i].amount = round(simBids[i].amount / settings.amountGrid) * settings.amountGrid;
+        }
+    }
 
+    size_t numUnique = 0;
+    unordered_map<Bid, size_t, SelectionInputHash, SameSelectionInputs> firstWithInputs;
+    for(size_t i = 0; i < simBids.size(); i++){
+        canonicalBid[i] = i;
+        if( settings.memoize ){
+            canonicalBid[i] = firstWithInputs.insert( make_pair(simBids[i], i) ).first->second;
+        }
+        if( canonicalBid[i] == i ){
+            numUnique++;
+        }
+    }
+    return( numUnique );
+}
 
-    // Read each cell into the string readProb
-    string readProb;
-    // Traverse rows and columns
-    for(int row = 0; row < aucTraits.numObsAucTypes; row++){
-        for(int col = 0; col < aucTraits.numBidderTypes; col++){
+// Give each bid that reused another's simulations that bid's probability and derivative, with the
+// cost implied by its own amount: the cost is the amount plus a term that depends only on the
+// probability and derivative, so only the amount changes.  Bids simulated at an amount rounded to
+// the grid get their own amount back the same way.
+void copyCanonicalResults(const vector<Bid>& bids, const vector<Bid>& simBids, const vector<size_t>& canonicalBid,
+                          vector< vector<SimulationResult> >& results){
 
-            // Take up to the next delimiter (comma unless it's the last column)
-            if( col < aucTraits.numBidderTypes - 1 ){
-                getline(infile, readProb, ',');
-            } else {
-                getline(infile, readProb, '\n');
+    for(size_t i = 0; i < bids.size(); i++){
+        size_t c = canonicalBid[i];
+        for(size_t k = 0; k < results.size(); k++){
+            SimulationResult result = results[k][c];
+            if( (bids[i].bidderType != 0) && (bids[i].amount != simBids[c].amount) ){
+                result.cost = bids[i].amount + (result.cost - simBids[c].amount);
             }
+            results[k][i] = result;
+        }
+    }
+}
 
-            // Define the probability of each bin and the cumulative probability
-            bidderTypeDist[row].push_back( atof(readProb.c_str()) );
-            bidderTypeCumDist[row].push_back( accumulate(bidderTypeDist[row].begin(), bidderTypeDist[row].end(), 0.0) );
+
+// Fingerprint of everything that determines a run's results: the simulation settings, the kernel,
+// the bids, the selection parameters, and the sample bids.  A checkpoint is only resumed by a run
+// with the same fingerprint.  (The distributions of bidder types and numbers of bids are assumed
+// to come with the sample bids.)
+uint64_t runFingerprint(SimulationSettings settings, const vector<Bid>& bids, const BidSelectionParams& nlp,
+                        const SampleBidStore& sampleBids){
+
+    uint64_t hash = fnvOffsetBasis;
+    hash = hashBytes(&settings.numAucSims, sizeof(settings.numAucSims), hash);
+    hash = hashBytes(&settings.seed, sizeof(settings.seed), hash);
+    hash = hashBytes(&settings.commonDraws, sizeof(settings.commonDraws), hash);
+    hash = hashBytes(&settings.adaptive, sizeof(settings.adaptive), hash);
+    hash = hashBytes(&settings.costTolerance, sizeof(settings.costTolerance), hash);
+    hash = hashBytes(&settings.minSims, sizeof(settings.minSims), hash);
+    hash = hashBytes(&settings.maxSims, sizeof(settings.maxSims), hash);
+    hash = hashBytes(&settings.drawMode, sizeof(settings.drawMode), hash);
+    hash = hashBytes(&settings.memoize, sizeof(settings.memoize), hash);
+    hash = hashBytes(&settings.amountGrid, sizeof(settings.amountGrid), hash);
+    hash = hashBytes(&settings.tableSize, sizeof(settings.tableSize), hash);
+    hash = hashBytes(&settings.tableDraws, sizeof(settings.tableDraws), hash);
+    hash = hashBytes(&settings.batched, sizeof(settings.batched), hash);
+    const char *kernelName = nestedLogitKernelName();
+    hash = hashBytes(kernelName, strlen(kernelName), hash);
+    hash = hashBytes(bids.data(), bids.size()*sizeof(Bid), hash);
+    hash = hashBytes(&nlp, sizeof(nlp), hash);
+
+    int numSamples = sampleBids.numSamples();
+    hash = hashBytes(&numSamples, sizeof(numSamples), hash);
+    for(int cell = 0; cell < sampleBids.numCells(); cell++){
+        for(int row = 0; row < numSamples; row++){
+            double amount = sampleBids.amount(cell, row);
+            int bidderType = sampleBids.bidderType(cell, row);
+            hash = hashBytes(&amount, sizeof(amount), hash);
+            hash = hashBytes(&bidderType, sizeof(bidderType), hash);
         }
     }
+    return( hash );
+}
 
-    // Return the cumulative probability since it's easier to compute with
-    return( bidderTypeCumDist );
+// Copy the results of the bids finished so far, for a checkpoint taken while threads are running
+CostProgress finishedProgress(const vector< vector<SimulationResult> >& results,
+                              const vector< atomic<char> >& bidFinished){
+
+    CostProgress progress;
+    progress.bidDone.assign(bidFinished.size(), 0);
+    SimulationResult unfinished = {0, 0, 0, 0, 0};
+    progress.results.assign(results.size(), vector<SimulationResult>(bidFinished.size(), unfinished));
+    for(size_t i = 0; i < bidFinished.size(); i++){
+        // The acquire pairs with the worker's release, so the bid's results are complete
+        if( bidFinished[i].load(memory_order_acquire) ){
+            progress.bidDone[i] = 1;
+            for(size_t k = 0; k < results.size(); k++){
+                progress.results[k][i] = results[k][i];
+            }
+        }
+    }
+    return( progress );
 }
 
 
-// Import the distribution of the number of bids in each observed type of auction
-vector< vector<double> > importNumBidDist(AucTraits aucTraits){
 
-    // Open the file and look for aucTraits.numObsAucTypes rows
-    ifstream infile("num_bid_distribution.csv");
+//// Comparison of draw modes
 
-    // Get the number of columns in the file
-    string firstLine;
-    getline(infile, firstLine);
-    int numCols = count(firstLine.begin(), firstLine.end(), ',') + 1;
-    // Reset to the start of the file
-    infile.seekg(0, ios::beg);
-    
-    // Declare the output array
-    vector<double> emptyVec;
-    vector< vector<double> > numBidDist(aucTraits.numObsAucTypes, emptyVec);
-    vector< vector<double> > numBidCumDist(aucTraits.numObsAucTypes, emptyVec);
+// Simulation counts, replications, and reference simulations used by the comparison
+const int numCompareCounts = 4;
+const int compareCounts[numCompareCounts] = {100, 200, 500, 1000};
+const int numCompareReps = 20;
+const int numReferenceSims = 20000;
+const int numDrawModes = 3;
+const char *drawModeNames[numDrawModes] = {"prng", "sobol", "antithetic"};
 
+// Squared errors of one bid's estimates, added up over unobserved auction types and replications,
+// for each draw mode and simulation count
+typedef struct {
+    double probSqError[numDrawModes][numCompareCounts];
+    double costSqError[numDrawModes][numCompareCounts];
+    int numEstimates;
+} DrawComparison;
 
-    // Read each cell into the string readProb
-    string readProb;
-    // Traverse rows and columns
-    for(int row = 0; row < aucTraits.numObsAucTypes; row++){
-        for(int col = 0; col < numCols; col++){
+// Compare the draw modes on bids claimed from nextTask.  The reference for each bid and auction type
+// is a pseudo-random run of numReferenceSims simulations on its own seed; each mode then estimates
+// the probability and cost numCompareReps times (on seeds seed, seed + 1, ...) at each count.
+void compareDrawsWorker(const vector<Bid>& bids, AucTraits aucTraits, SimulationSettings settings,
+                        const SampleBidStore& sampleBids,
+                        const BidSelectionParams& nlp,
+                        const vector<AliasTable>& bidderTypeDist,
+                        const vector<AliasTable>& numBidDist,
+                        atomic<size_t>& nextTask,
+                        vector<DrawComparison>& comparisons){
 
-            // Take up to the next delimiter (comma unless it's the last column)
-            if( col < numCols - 1 ){
-                getline(infile, readProb, ',');
-            } else {
-                getline(infile, readProb, '\n');
+    AuctionScratch scratch(numBidDist);
+    CompetitorDraws draws;
+    uint64_t referenceSeed = settings.seed + 0x9E3779B97F4A7C15ULL;
+
+    while(true){
+
+        size_t bidIndex = nextTask.fetch_add(1);
+        if( bidIndex >= bids.size() ){
+            break;
+        }
+        const Bid& currentBid = bids[bidIndex];
+        int obsAucType = currentBid.obsAucType - 1;
+        const AliasTable& numBidTable = numBidDist[obsAucType];
+        const AliasTable& bidderTypeTable = bidderTypeDist[obsAucType];
+        DrawComparison& comparison = comparisons[bidIndex];
+        memset(&comparison, 0, sizeof(comparison));
+
+        for(int uAucType = 0; uAucType < aucTraits.numUnobsAucTypes; uAucType++){
+
+            draws.setDrawMode(prngDraws, NULL);
+            draws.draw(referenceSeed, bidIndex, uAucType, 0, numReferenceSims, numBidTable, bidderTypeTable,
+                       sampleBids.numSamples());
+            SimulationSums reference = simulateAuctions(currentBid, uAucType, draws, 0, numReferenceSims,
+                                                        sampleBids, nlp, scratch);
+            double referenceProb = reference.probSum / numReferenceSims;
+            double referenceCost = currentBid.amount + reference.probSum / reference.probDerSum;
+
+            for(int mode = 0; mode < numDrawModes; mode++){
+                draws.setDrawMode((DrawMode) mode, settings.sobol);
+                for(int rep = 0; rep < numCompareReps; rep++){
+                    for(int c = 0; c < numCompareCounts; c++){
+                        int numSims = compareCounts[c];
+                        draws.draw(settings.seed + rep, bidIndex, uAucType, 0, numSims, numBidTable,
+                                   bidderTypeTable, sampleBids.numSamples());
+                        SimulationSums sums = simulateAuctions(currentBid, uAucType, draws, 0, numSims,
+                                                               sampleBids, nlp, scratch);
+                        double probError = sums.probSum / numSims - referenceProb;
+                        double costError = currentBid.amount + sums.probSum / sums.probDerSum - referenceCost;
+                        comparison.probSqError[mode][c] += probError*probError;
+                        comparison.costSqError[mode][c] += costError*costError;
+                    }
+                }
             }
+            comparison.numEstimates += numCompareReps;
+        }
+    }
+}
 
-            // Define the probability of each bin and the cumulative probability
-            numBidDist[row].push_back( atof(readProb.c_str()) );
-            numBidCumDist[row].push_back( accumulate(numBidDist[row].begin(), numBidDist[row].end(), 0.0) );
+// Run the comparison on the first numCompareBids bids that aren't the outside option, print a table
+// of root mean squared errors, and write it to draw_comparison.csv.  The variance reduction column is
+// the pseudo-random mean squared error at the same count divided by the mode's: roughly how many
+// times more pseudo-random simulations the mode is worth.
+void compareDrawModes(const vector<Bid>& allBids, AucTraits aucTraits, SimulationSettings settings,
+                      const SampleBidStore& sampleBids, const BidSelectionParams& nlp,
+                      const vector<AliasTable>& bidderTypeDist, const vector<AliasTable>& numBidDist,
+                      int numCompareBids, int numThreads){
+
+    vector<Bid> bids;
+    for(size_t i = 0; (i < allBids.size()) && ((int)bids.size() < numCompareBids); i++){
+        if( allBids[i].bidderType != 0 ){
+            bids.push_back( allBids[i] );
         }
     }
-    
-    // Return the cumulative probability since it's easier to compute with
-    return( numBidCumDist );
+    cout << "Comparing draw modes on " << bids.size() << " bids with " << numCompareReps
+         << " replications against " << numReferenceSims << " pseudo-random simulations\n";
+
+    vector<DrawComparison> comparisons(bids.size());
+    atomic<size_t> nextTask(0);
+    vector<thread> threads;
+    for(int t = 0; t < numThreads; t++){
+        threads.push_back( thread(compareDrawsWorker, cref(bids), aucTraits, settings, cref(sampleBids),
+                                  cref(nlp), cref(bidderTypeDist), cref(numBidDist), ref(nextTask),
+                                  ref(comparisons)) );
+    }
+    for(int t = 0; t < numThreads; t++){
+        threads[t].join();
+    }
+
+    // Pool the squared errors over bids
+    DrawComparison total;
+    memset(&total, 0, sizeof(total));
+    for(size_t i = 0; i < comparisons.size(); i++){
+        for(int mode = 0; mode < numDrawModes; mode++){
+            for(int c = 0; c < numCompareCounts; c++){
+                total.probSqError[mode][c] += comparisons[i].probSqError[mode][c];
+                total.costSqError[mode][c] += comparisons[i].costSqError[mode][c];
+            }
+        }
+        total.numEstimates += comparisons[i].numEstimates;
+    }
+    if( total.numEstimates == 0 ){
+        return;
+    }
+
+    ofstream outputFile;
+    outputFile.open("draw_comparison.csv");
+    outputFile << "mode, sims, prob_rmse, cost_rmse, cost_variance_reduction\n";
+    printf("%-12s %6s %14s %14s %18s\n", "mode", "sims", "prob RMSE", "cost RMSE", "variance reduction");
+    for(int mode = 0; mode < numDrawModes; mode++){
+        for(int c = 0; c < numCompareCounts; c++){
+            double probRMSE = sqrt(total.probSqError[mode][c] / total.numEstimates);
+            double costRMSE = sqrt(total.costSqError[mode][c] / total.numEstimates);
+            double reduction = total.costSqError[prngDraws][c] / total.costSqError[mode][c];
+            printf("%-12s %6d %14.6g %14.6g %18.2f\n", drawModeNames[mode], compareCounts[c], probRMSE,
+                   costRMSE, reduction);
+            outputFile << drawModeNames[mode] << ", " << compareCounts[c] << ", " << probRMSE << ", "
+                       << costRMSE << ", " << reduction << "\n";
+        }
+    }
+    outputFile.close();
 }
 
 
 
+// Compare the costs from the inclusive value tables with the brute-force simulations, on the first
+// numCheckBids simulated bids other than the outside option from firstBid on (the first row of the
+// shard).  The brute-force path draws
+// settings.numAucSims auctions for each bid and type from the bid's own streams, as a run without
+// tables would.  Prints the root mean squared differences, and the mean absolute cost difference in
+// units of the brute-force standard error: values near 0.8 (the mean absolute value of a standard
+// normal) mean that the table is as close as the simulation noise allows.
+void checkInclusiveValueTable(const vector<Bid>& bids, const vector<size_t>& canonicalBid, AucTraits aucTraits,
+                              SimulationSettings settings, const SampleBidStore& sampleBids,
+                              const BidSelectionParams& nlp, const vector<AliasTable>& bidderTypeDist,
+                              const vector<AliasTable>& numBidDist,
+                              const vector< vector<SimulationResult> >& results, size_t firstBid, size_t endBid,
+                              int numCheckBids){
+
+    AuctionScratch scratch(numBidDist);
+    CompetitorDraws draws;
+    double probSqDiff = 0;
+    double probDerSqDiff = 0;
+    double costSqDiff = 0;
+    double scaledCostDiff = 0;
+    int numCompared = 0;
+    int numBids = 0;
+
+    for(size_t i = firstBid; (i < endBid) && (numBids < numCheckBids); i++){
+        if( (bids[i].bidderType == 0) || (canonicalBid[i] != i) ){
+            continue;
+        }
+        numBids++;
+        int obsAucType = bids[i].obsAucType - 1;
+        for(int uAucType = 0; uAucType < aucTraits.numUnobsAucTypes; uAucType++){
+            draws.draw(settings.seed, i, uAucType, 0, settings.numAucSims, numBidDist[obsAucType],
+                       bidderTypeDist[obsAucType], sampleBids.numSamples());
+            SimulationSums sums = simulateAuctions(bids[i], uAucType, draws, 0, settings.numAucSims, sampleBids,
+                                                   nlp, scratch);
+            double prob = sums.probSum / settings.numAucSims;
+            double probDer = sums.probDerSum / settings.numAucSims;
+            double cost = bids[i].amount + sums.probSum / sums.probDerSum;
+            double costSE = costStandardError(sums, settings.numAucSims);
+
+            const SimulationResult& result = results[uAucType][i];
+            probSqDiff += (result.prob - prob)*(result.prob - prob);
+            probDerSqDiff += (result.probDer - probDer)*(result.probDer - probDer);
+            costSqDiff += (result.cost - cost)*(result.cost - cost);
+            scaledCostDiff += fabs(result.cost - cost) / costSE;
+            numCompared++;
+        }
+    }
+    if( numCompared == 0 ){
+        return;
+    }
+
+    cout << "Inclusive value table (" << settings.tableSize << " quantiles of " << settings.tableDraws
+         << " draws) vs " << settings.numAucSims << " simulations on " << numBids << " bids:\n"
+         << "  probability RMSE " << sqrt(probSqDiff / numCompared) << ", derivative RMSE "
+         << sqrt(probDerSqDiff / numCompared) << ", cost RMSE " << sqrt(costSqDiff / numCompared)
+         << ", mean |cost difference| / simulation SE " << scaledCostDiff / numCompared << "\n";
+}
+
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -218,116 +665,592 @@ vector< vector<double> > importNumBidDist(AucTraits aucTraits){
 // Strategy: import all data, then simulate 1000 auctions for each bid and each auction type. Use the mean
 // results of the auction to find true selection probabilities and derivatives, then use those to infer
 // seller costs.
-int main(){
+// Command line options:
+//   --threads N       simulate bids on N threads (default 1; 0 uses every available core)
+//   --seed S          seed for the random draws in the simulated auctions (default 1)
+//   --num-samples N   sample bids to import from each sample bid file (default 10000)
+//   --sample-cache F  map the sample bids from the cache file F written by convert_sample_bids.exe
+//                     instead of importing the sample bid files
+//   --verify-cache    with --sample-cache, also check the cache's column checksums (a pass over the file)
+//   --manifest F      manifest of the sample bid files (default sample_bids_manifest.txt; see import_data.hpp)
+//   --generate-samples  draw the sample bids in memory from template_data.csv and unobs_auc_type_probs.csv
+//                     (see sample_bid_generator.hpp) instead of importing the sample bid files
+//   --export-samples  with --generate-samples, also write the sample bids to sample_bids_*.csv and
+//                     the manifest
+//   --bid-columns F   column mapping for template_data.csv (default bid_columns.txt; see bid_data_loader.hpp)
+//   --simd K          kernel for the selection probabilities: auto (default), scalar, avx2, avx512
+//   --common-draws M  share competitor draws: none (default), types (across the unobserved auction
+//                     types of each bid), or bids (across all bids with the same observed auction type)
+//   --model M         bid selection model (selection_models.hpp): nested (nested logit, the default) or
+//                     logit (multinomial logit), which also sets the layout of coeff.txt
+//   --sims N          simulated auctions per bid and unobserved auction type (default 1000)
+//   --adaptive TOL    instead of a fixed count, simulate each bid and auction type until the standard
+//                     error of its cost is at most TOL; adds the count and standard error to the output
+//   --min-sims N      adaptive batch size: simulations before the first check and between checks (default 100)
+//   --max-sims N      adaptive cap on the simulations for any bid and auction type (default 10000)
+//   --draws D         uniforms behind the competitor draws: prng (default), sobol, or antithetic
+//   --memoize         simulate each distinct set of selection model inputs once and reuse the results
+//                     for every bid that shares them
+//   --amount-grid G   with --memoize, round bid amounts to multiples of G before matching bids
+//   --inclusive-table Q  instead of simulating each bid, evaluate it against Q quantiles of the
+//                     competitors' inclusive value, simulated once per auction type cell; the costs of
+//                     the first 50 bids are checked against simulations
+//   --inclusive-table-draws M  simulated auctions behind each table (default 100000)
+//   --batched         evaluate every bid of an observed auction type against one shared bank of
+//                     simulated auctions at once (implies --common-draws bids; no checkpoints)
+//   --checkpoint-every T  save progress to estimated_costs.ckpt every T seconds (default 600; 0 never)
+//   --resume          continue the run saved in estimated_costs.ckpt (with the same settings and inputs)
+//   --shard i/N       simulate only the i-th of N ranges of bids and write their lines to
+//                     estimated_costs.shard_i_of_N.csv (see cost_shards.hpp; merge with merge_cost_shards.exe)
+//   --bootstrap R     after the cost estimates, resample the auctions R times and write percentile
+//                     intervals of each cost to estimated_costs_bootstrap.csv (see cost_bootstrap.hpp)
+//   --bootstrap-sims N  simulated auctions per bid, type, and replicate (default 200)
+//   --bootstrap-level X  coverage of the intervals (default 0.95)
+//   --report F        write the time of each phase and counts of the work done to F as JSON
+//   --progress-every T  print the progress, throughput, and estimated time left to stderr every T
+//                     seconds while simulating (default 10; 0 never)
+//   --compare-draws N instead of estimating costs, compare the draw modes on the first N bids and
+//                     write the errors to draw_comparison.csv
+int main(int argc, char *argv[]){
+
+    // Read command line options
+    int numThreads = 1;
+    int numSamples = 10000;
+    SimulationSettings settings;
+    settings.numAucSims = 1000;
+    settings.seed = 1;
+    settings.commonDraws = independentDraws;
+    settings.adaptive = false;
+    settings.costTolerance = 0;
+    settings.minSims = 100;
+    settings.maxSims = 10000;
+    settings.drawMode = prngDraws;
+    settings.sobol = NULL;
+    int numCompareBids = 0;
+    int checkpointInterval = 600;
+    settings.memoize = false;
+    settings.amountGrid = 0;
+    settings.tableSize = 0;
+    settings.tableDraws = 100000;
+    settings.ivTable = NULL;
+    settings.batched = false;
+    bool resume = false;
+    int shardIndex = 0;
+    int numShards = 0;
+    const char *reportFile = NULL;
+    BootstrapSettings bootstrap;
+    bootstrap.numReplicates = 0;
+    bootstrap.numSims = 200;
+    bootstrap.level = 0.95;
+    int progressInterval = 10;
+    SelectionModel selectionModel = nestedLogitModel;
+    const char *sampleCacheFile = NULL;
+    bool verifyCache = false;
+    bool generateSamples = false;
+    bool exportSamples = false;
+    const char *manifestFile = sampleBidManifestFile;
+    const char *bidColumnFile = "bid_columns.txt";
+    for(int i = 1; i < argc; i++){
+        if( (strcmp(argv[i], "--threads") == 0) && (i + 1 < argc) ){
+            numThreads = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--seed") == 0) && (i + 1 < argc) ){
+            settings.seed = strtoull(argv[++i], NULL, 10);
+        } else if( (strcmp(argv[i], "--num-samples") == 0) && (i + 1 < argc) ){
+            numSamples = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--sample-cache") == 0) && (i + 1 < argc) ){
+            sampleCacheFile = argv[++i];
+        } else if( strcmp(argv[i], "--verify-cache") == 0 ){
+            verifyCache = true;
+        } else if( (strcmp(argv[i], "--manifest") == 0) && (i + 1 < argc) ){
+            manifestFile = argv[++i];
+        } else if( strcmp(argv[i], "--generate-samples") == 0 ){
+            generateSamples = true;
+        } else if( strcmp(argv[i], "--export-samples") == 0 ){
+            exportSamples = true;
+        } else if( (strcmp(argv[i], "--bid-columns") == 0) && (i + 1 < argc) ){
+            bidColumnFile = argv[++i];
+        } else if( (strcmp(argv[i], "--simd") == 0) && (i + 1 < argc) ){
+            if( !setNestedLogitKernel(argv[++i]) ){
+                cout << "Error: kernel " << argv[i] << " is unknown or not supported by this CPU.\n";
+                return(1);
+            }
+        } else if( (strcmp(argv[i], "--common-draws") == 0) && (i + 1 < argc) ){
+            i++;
+            if( strcmp(argv[i], "none") == 0 ){
+                settings.commonDraws = independentDraws;
+            } else if( strcmp(argv[i], "types") == 0 ){
+                settings.commonDraws = commonAcrossTypes;
+            } else if( strcmp(argv[i], "bids") == 0 ){
+                settings.commonDraws = commonAcrossBids;
+            } else {
+                cout << "Error: --common-draws must be none, types, or bids.\n";
+                return(1);
+            }
+        } else if( (strcmp(argv[i], "--model") == 0) && (i + 1 < argc) ){
+            i++;
+            if( strcmp(argv[i], "nested") == 0 ){
+                selectionModel = nestedLogitModel;
+            } else if( strcmp(argv[i], "logit") == 0 ){
+                selectionModel = multinomialLogitModel;
+            } else {
+                cout << "Error: --model must be nested or logit.\n";
+                return(1);
+            }
+        } else if( (strcmp(argv[i], "--sims") == 0) && (i + 1 < argc) ){
+            settings.numAucSims = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--adaptive") == 0) && (i + 1 < argc) ){
+            settings.adaptive = true;
+            settings.costTolerance = atof(argv[++i]);
+        } else if( (strcmp(argv[i], "--min-sims") == 0) && (i + 1 < argc) ){
+            settings.minSims = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--max-sims") == 0) && (i + 1 < argc) ){
+            settings.maxSims = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--draws") == 0) && (i + 1 < argc) ){
+            i++;
+            if( strcmp(argv[i], "prng") == 0 ){
+                settings.drawMode = prngDraws;
+            } else if( strcmp(argv[i], "sobol") == 0 ){
+                settings.drawMode = sobolDraws;
+            } else if( strcmp(argv[i], "antithetic") == 0 ){
+                settings.drawMode = antitheticDraws;
+            } else {
+                cout << "Error: --draws must be prng, sobol, or antithetic.\n";
+                return(1);
+            }
+        } else if( (strcmp(argv[i], "--checkpoint-every") == 0) && (i + 1 < argc) ){
+            checkpointInterval = atoi(argv[++i]);
+        } else if( strcmp(argv[i], "--memoize") == 0 ){
+            settings.memoize = true;
+        } else if( (strcmp(argv[i], "--amount-grid") == 0) && (i + 1 < argc) ){
+            settings.amountGrid = atof(argv[++i]);
+        } else if( (strcmp(argv[i], "--inclusive-table") == 0) && (i + 1 < argc) ){
+            settings.tableSize = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--inclusive-table-draws") == 0) && (i + 1 < argc) ){
+            settings.tableDraws = atoi(argv[++i]);
+        } else if( strcmp(argv[i], "--batched") == 0 ){
+            settings.batched = true;
+        } else if( strcmp(argv[i], "--resume") == 0 ){
+            resume = true;
+        } else if( (strcmp(argv[i], "--shard") == 0) && (i + 1 < argc) ){
+            if( !parseShardOption(argv[++i], shardIndex, numShards) ){
+                cout << "Error: --shard must be i/N with 1 <= i <= N.\n";
+                return(1);
+            }
+        } else if( (strcmp(argv[i], "--bootstrap") == 0) && (i + 1 < argc) ){
+            bootstrap.numReplicates = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--bootstrap-sims") == 0) && (i + 1 < argc) ){
+            bootstrap.numSims = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--bootstrap-level") == 0) && (i + 1 < argc) ){
+            bootstrap.level = atof(argv[++i]);
+        } else if( (strcmp(argv[i], "--report") == 0) && (i + 1 < argc) ){
+            reportFile = argv[++i];
+        } else if( (strcmp(argv[i], "--progress-every") == 0) && (i + 1 < argc) ){
+            progressInterval = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--compare-draws") == 0) && (i + 1 < argc) ){
+            numCompareBids = atoi(argv[++i]);
+        } else {
+            cout << "Error: unrecognized option " << argv[i] << ".\n";
+            cout << "Usage: calculate_costs.exe [--threads N] [--seed S] [--num-samples N] [--sample-cache F]"
+                 << " [--verify-cache] [--manifest F] [--generate-samples] [--export-samples] [--bid-columns F] [--simd K] [--model M]"
+                 << " [--common-draws M] [--sims N] [--adaptive TOL] [--min-sims N] [--max-sims N]"
+                 << " [--draws D] [--memoize] [--amount-grid G]"
+                 << " [--inclusive-table Q] [--inclusive-table-draws M] [--batched]"
+                 << " [--checkpoint-every T] [--resume] [--shard i/N] [--compare-draws N]"
+                 << " [--bootstrap R] [--bootstrap-sims N] [--bootstrap-level X] [--report F]"
+                 << " [--progress-every T]\n";
+            return(1);
+        }
+    }
+    if( numSamples <= 0 ){
+        cout << "Error: --num-samples must be positive.\n";
+        return(1);
+    }
+    if( settings.numAucSims <= 0 ){
+        cout << "Error: --sims must be positive.\n";
+        return(1);
+    }
+    if( settings.adaptive && ((settings.costTolerance <= 0) || (settings.minSims <= 0) ||
+                              (settings.maxSims < settings.minSims)) ){
+        cout << "Error: --adaptive needs a positive tolerance and 0 < --min-sims <= --max-sims.\n";
+        return(1);
+    }
+    if( (settings.amountGrid < 0) || ((settings.amountGrid > 0) && !settings.memoize) ){
+        cout << "Error: --amount-grid must be positive and needs --memoize.\n";
+        return(1);
+    }
+    if( (settings.tableSize < 0) || (settings.tableDraws <= 0) || ((settings.tableSize > 0) && settings.adaptive) ){
+        cout << "Error: --inclusive-table needs a positive size and positive draws, and can't be used with --adaptive.\n";
+        return(1);
+    }
+    if( settings.batched && (settings.adaptive || (settings.tableSize > 0) || resume) ){
+        cout << "Error: --batched can't be used with --adaptive, --inclusive-table, or --resume.\n";
+        return(1);
+    }
+    if( settings.batched ){
+        // The batched engine needs one bank per observed auction type, and finishes bids in cells
+        // rather than one at a time, so it doesn't checkpoint
+        settings.commonDraws = commonAcrossBids;
+        checkpointInterval = 0;
+    }
+    if( (generateSamples && (sampleCacheFile != NULL)) || (exportSamples && !generateSamples) ){
+        cout << "Error: --generate-samples can't be used with --sample-cache, and --export-samples needs --generate-samples.\n";
+        return(1);
+    }
+    if( verifyCache && (sampleCacheFile == NULL) ){
+        cout << "Error: --verify-cache needs --sample-cache.\n";
+        return(1);
+    }
+    if( (numShards > 0) && (numCompareBids > 0) ){
+        cout << "Error: --shard can't be used with --compare-draws.\n";
+        return(1);
+    }
+    if( (bootstrap.numReplicates < 0) || (bootstrap.numSims <= 0) || !(bootstrap.level > 0) || !(bootstrap.level < 1) ){
+        cout << "Error: --bootstrap and --bootstrap-sims must be positive, and --bootstrap-level between 0 and 1.\n";
+        return(1);
+    }
+    if( (bootstrap.numReplicates > 0) && ((numShards > 0) || (numCompareBids > 0)) ){
+        cout << "Error: --bootstrap can't be used with --shard or --compare-draws.\n";
+        return(1);
+    }
+    if( numThreads <= 0 ){
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+
+    // A shard writes its own output and checkpoint, so that shards can share a directory
+    string outputName = "estimated_costs.csv";
+    string checkpointName = checkpointFile;
+    if( numShards > 0 ){
+        outputName = shardFileName("estimated_costs", "csv", shardIndex, numShards);
+        checkpointName = shardFileName("estimated_costs", "ckpt", shardIndex, numShards);
+    }
+
+    // Phase timers and work counters for the progress lines and --report
+    RunReport runReport;
 
     //////////////////////////////////////////////////////////////////////////////
-    //// Part 1: Import inverse CDFs and nested logit parameters
-    
-    // Use the getAucTraits function to get the number of bidder and auction types
-    AucTraits aucTraits;
-    aucTraits = getAucTraits();
-    if( (aucTraits.numBidderTypes == 0) | (aucTraits.numUnobsAucTypes == 0) ){
-        cout << "Error: zero bidder or auction types.\n";
+    //// Part 1: Import bids, inverse CDFs, and nested logit parameters
+
+    // Load all bids up front so that they can be divided among threads (and sample bids generated
+    // from them)
+    runReport.beginPhase("load_bids");
+    vector<Bid> bids;
+    if( !loadBidData("template_data.csv", bidColumnFile, numThreads, bids) ){
         return(1);
     }
 
-    // Import sample bids as a bidder_types x ObsAucTypes x UnobsAUcTypes x 10000 vector
-    // (Dimensions unknown at compile time)
-    Bid emptyBid;
-    vector< vector< vector< vector<Bid> > > > sampleBids( aucTraits.numBidderTypes,
-            vector< vector< vector<Bid> > >( aucTraits.numObsAucTypes,
-                    vector< vector<Bid> >(aucTraits.numUnobsAucTypes, vector<Bid>(10000, emptyBid)) ) );    
-    // Use a function (returning void) to import the bids. (Function takes the whole vector as an
-    // argument, but only works with a reference to the memory address.)
-    importSampleBids(sampleBids, aucTraits);
+    // Sample bids for each bidder type, observed auction type, and unobserved auction type, held in
+    // one contiguous store, and the number of bidder and auction types
+    AucTraits aucTraits;
+    SampleBidStore sampleBids;
+    if( generateSamples ){
+        // Draw them from the bids, weighted by their unobserved auction type probabilities
+        runReport.beginPhase("generate_sample_bids");
+        int numUnobsAucTypes;
+        vector<double> typeProbs;
+        SampleBidSettings sampleSettings;
+        sampleSettings.gridPoints = 4096;
+        sampleSettings.bandwidth = 0.1;
+        sampleSettings.kdeBins = 16384;
+        sampleSettings.seed = settings.seed;
+        if( !readTypeProbs("unobs_auc_type_probs.csv", numUnobsAucTypes, typeProbs) ||
+            !generateSampleBids(sampleBids, bids, typeProbs, numUnobsAucTypes, numSamples, sampleSettings, numThreads) ){
+            return(1);
+        }
+        aucTraits = sampleBids.aucTraits();
+        if( exportSamples && !exportSampleBids(sampleBids, manifestFile, numThreads) ){
+            return(1);
+        }
+    } else if( sampleCacheFile != NULL ){
+        // Map a cache file, which also records the number of types
+        runReport.beginPhase("import_sample_bids");
+        if( !sampleBids.mapCache(sampleCacheFile, numSamples, verifyCache) ){
+            return(1);
+        }
+        aucTraits = sampleBids.aucTraits();
+        cout << "Mapped " << sampleBids.numCells() << " cells of sample bids from " << sampleCacheFile << "\n";
+    } else {
+        // The manifest gives the number of bidder and auction types and the file of each cell
+        runReport.beginPhase("read_manifest");
+        SampleBidManifest manifest;
+        if( !readSampleBidManifest(manifestFile, manifest) ){
+            return(1);
+        }
+        aucTraits = manifest.aucTraits;
+
+        // Import numSamples sample bids from each file, numThreads files at a time
+        runReport.beginPhase("import_sample_bids");
+        sampleBids.allocate(aucTraits, numSamples);
+        if( !importSampleBids(sampleBids, manifest, numThreads) ){
+            return(1);
+        }
+    }
 
     // Import parameters as a vector (this restricts hard-coded changes to the function where they're used)
-    BidSelectionParams nlp = getBidSelectionParams();
+    runReport.beginPhase("import_parameters");
+    BidSelectionParams nlp = getBidSelectionParams(selectionModel);
 
     // Import distribution of bidder types
-    vector< vector<double> > bidderTypeCumDist = importBidderTypeDist(aucTraits);
+    vector<AliasTable> bidderTypeDist = importBidderTypeDist(aucTraits);
     // Import distribution of number of bids
-    vector< vector<double> > numBidCumDist = importNumBidDist(aucTraits);
+    vector<AliasTable> numBidDist = importNumBidDist(aucTraits);
+
+    // Sobol sequence with a dimension for the number of other bids and two (bidder type and sample
+    // row) for each possible competitor
+    int maxOtherBids = 0;
+    for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+        maxOtherBids = max(maxOtherBids, numBidDist[j].size());
+    }
+    SobolSequence sobol(1 + 2*maxOtherBids);
+    settings.sobol = &sobol;
 
     
     ///////////////////////////////////////////////////////////////////////////////
     //// Part 2: simulate auctions for each bid in the data
 
-    // Skip the header row and take the first bid
-    FILE* bidFile = fopen("template_data.csv", "r");
-    char line[10000];
-    char *res = fgets(line, sizeof(line), bidFile); // Gets header line, which we ignore
-
-    // Get bids from other lines and process auctions    
-    Bid currentBid;
-    currentBid.isLastBid = false;
-
-    // Number of times to simulate the auction
-    int numAucSims = 1000;
-    // Variables to calculate and store simulation outcomes
-    double probSum;
-    double probDerSum;
-    pair<double, double> simulationResult;
-    vector<double> emptyVec;
-    vector< vector<double> > simulatedProb( aucTraits.numUnobsAucTypes, emptyVec );
-    vector< vector<double> > simulatedProbDeriv( aucTraits.numUnobsAucTypes, emptyVec );
-    vector< vector<double> > costs( aucTraits.numUnobsAucTypes, emptyVec );
-
-    // Debugging: only run for the first 11 bids
-    int bidCount = 0;
-    
-    while( ! currentBid.isLastBid ){
+    // Only compare the draw modes if asked to
+    if( numCompareBids > 0 ){
+        compareDrawModes(bids, aucTraits, settings, sampleBids, nlp, bidderTypeDist, numBidDist,
+                         numCompareBids, numThreads);
+        return 0;
+    }
 
-        currentBid = getBidData(bidFile);
-        
-        // Simulate the bid 1,000 times for each auction type
-        for(int uAucType = 0; uAucType < aucTraits.numUnobsAucTypes; uAucType++){
+    // Bids that can reuse the simulations of an earlier bid, and the inputs that are simulated
+    runReport.beginPhase("setup");
+    vector<Bid> simBids = bids;
+    vector<size_t> canonicalBid;
+    size_t numUnique = findCanonicalBids(settings, simBids, canonicalBid);
 
-            // Skip if this is an outside option bid, but insert a placeholder
-            if( currentBid.bidderType == 0 ){
-                simulatedProb[uAucType].push_back( -99 );
-                simulatedProbDeriv[uAucType].push_back( -99 );
-                costs[uAucType].push_back( -99 );
-                continue;
-            }
-            
-            // Reset simulation summary variables
-            probSum = 0;
-            probDerSum = 0;
-
-            // Simulate results from the current bid numAucSims times, getting the selection probability and its derivative
-            for(int i = 0; i < numAucSims; i++){
-                simulationResult = simulateAuction(currentBid, uAucType, aucTraits.numBidderTypes, sampleBids,
-                                                   nlp, bidderTypeCumDist, numBidCumDist);
-                probSum += simulationResult.first;
-                probDerSum += simulationResult.second;
+    // Store simulation outcomes in one slot per bid for each auction type, filled in by the threads,
+    // starting from the bids a checkpoint already finished when resuming
+    CostProgress progress;
+    progress.results.assign(aucTraits.numUnobsAucTypes, vector<SimulationResult>(bids.size()));
+    progress.bidDone.assign(bids.size(), 0);
+    uint64_t fingerprint = runFingerprint(settings, simBids, nlp, sampleBids);
+
+    // Rows of template_data.csv this run writes: all of them, or the shard's range.  A shard's
+    // checkpoint is only resumed by the same shard.
+    ShardHeader shard = {shardIndex, numShards, 0, (long long)bids.size(), (long long)bids.size(), settings.seed,
+                         fingerprint};
+    uint64_t checkpointFingerprint = fingerprint;
+    if( numShards > 0 ){
+        shardRows(bids.size(), shardIndex, numShards, shard.firstRow, shard.endRow);
+        checkpointFingerprint = hashBytes(&shardIndex, sizeof(shardIndex), checkpointFingerprint);
+        checkpointFingerprint = hashBytes(&numShards, sizeof(numShards), checkpointFingerprint);
+        cout << "Shard " << shardIndex << " of " << numShards << ": bids " << shard.firstRow << " to "
+             << shard.endRow - 1 << " of " << bids.size() << "\n";
+    }
+    if( resume ){
+        if( !readCheckpoint(checkpointName.c_str(), checkpointFingerprint, progress) ){
+            return(1);
+        }
+    }
+
+    // Bids outside the shard count as finished from the start, except the ones whose simulations a
+    // bid in the shard reuses
+    if( numShards > 0 ){
+        vector<char> needed(bids.size(), 0);
+        for(long long i = shard.firstRow; i < shard.endRow; i++){
+            needed[i] = 1;
+            needed[canonicalBid[i]] = 1;
+        }
+        for(size_t i = 0; i < bids.size(); i++){
+            if( !needed[i] ){
+                progress.bidDone[i] = 1;
             }
-            // cout << (probSum / numAucSims) << "; " << (probDerSum / numAucSims) << "; " << (probSum / probDerSum) << "\n";
-            // Store the averages and calculate the implied cost
-            simulatedProb[uAucType].push_back( probSum / numAucSims );
-            simulatedProbDeriv[uAucType].push_back( probDerSum / numAucSims );
+        }
+    }
+    if( resume ){
+        vector<char>::iterator shardStart = progress.bidDone.begin() + shard.firstRow;
+        vector<char>::iterator shardEnd = progress.bidDone.begin() + shard.endRow;
+        size_t numDone = count(shardStart, shardEnd, 1);
+        size_t firstUnfinished = find(shardStart, shardEnd, 0) - progress.bidDone.begin();
+        cout << "Resuming from " << checkpointName << ": " << numDone << " of " << shard.endRow - shard.firstRow
+             << " bids finished (all bids before bid " << firstUnfinished << ")\n";
+    }
+    vector< vector<SimulationResult> >& results = progress.results;
+    vector< atomic<char> > bidFinished(bids.size());
+    for(size_t i = 0; i < bids.size(); i++){
+        bidFinished[i].store(progress.bidDone[i]);
+    }
 
-            // Costs need to be multiplied by 1 - commission to be accurate
-            costs[uAucType].push_back( currentBid.amount + (probSum / probDerSum) );
+    // Build the inclusive value tables if they replace the simulations
+    if( settings.tableSize > 0 ){
+        settings.ivTable = new InclusiveValueTable(aucTraits, settings.seed, settings.tableDraws, settings.tableSize,
+                                                   numBidDist, bidderTypeDist, sampleBids, nlp);
+    }
+
+    // When all bids of an observed auction type share their competitors, draw them once up front
+    // (enough for the largest number of simulations any bid can use)
+    vector<CompetitorDraws> obsTypeDraws;
+    if( settings.commonDraws == commonAcrossBids ){
+        int bankSims = (settings.adaptive ? settings.maxSims : settings.numAucSims);
+        obsTypeDraws.resize(aucTraits.numObsAucTypes);
+        for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+            obsTypeDraws[j].setDrawMode(settings.drawMode, settings.sobol);
+            obsTypeDraws[j].draw(settings.seed, j, sharedDrawStream, 0, bankSims, numBidDist[j],
+                                 bidderTypeDist[j], sampleBids.numSamples());
+            runReport.counters.competitorsDrawn.fetch_add(obsTypeDraws[j].numCompetitors(0, bankSims));
+        }
+    }
+
+    // Simulate the bids for each auction type, spreading the work over numThreads threads
+    atomic<size_t> nextTask(0);
+    atomic<int> threadsRunning(numThreads);
+    vector<thread> threads;
+    vector< vector<size_t> > obsTypeBids;
+    vector< vector< vector<double> > > cellValues;
+    vector<BatchTask> tasks;
+    if( settings.batched ){
+        setUpBatches(simBids, canonicalBid, progress.bidDone, aucTraits, settings, obsTypeDraws, sampleBids, nlp, obsTypeBids,
+                     cellValues, tasks, results, runReport.counters);
+    }
+
+    // Bids this run has to simulate (only its shard, without the outside option and reused or finished bids)
+    long long numToSimulate = 0;
+    for(size_t i = 0; i < bids.size(); i++){
+        if( (canonicalBid[i] == i) && (bids[i].bidderType != 0) && !progress.bidDone[i] ){
+            numToSimulate++;
+        }
+    }
+    cout << "Simulating " << numToSimulate << " bids on " << numThreads << " threads with the "
+         << nestedLogitKernelName() << " kernel\n";
+    runReport.beginPhase("simulate");
+    runReport.startProgress(numToSimulate);
+    for(int t = 0; t < numThreads; t++){
+        if( settings.batched ){
+            threads.push_back( thread(batchedBidsWorker, cref(simBids), cref(obsTypeBids), cref(cellValues),
+                                      cref(tasks), settings, cref(nlp), ref(nextTask), ref(results),
+                                      ref(runReport.counters), ref(threadsRunning)) );
+        } else {
+            threads.push_back( thread(simulateBidsWorker, cref(simBids), aucTraits, settings, cref(sampleBids),
+                                      cref(nlp), cref(bidderTypeDist), cref(numBidDist), cref(obsTypeDraws),
+                                      cref(canonicalBid), ref(nextTask), ref(results), ref(bidFinished),
+                                      ref(runReport.counters), ref(threadsRunning)) );
         }
-        bidCount++;        
     }
 
-    // Write probabilities, derivatives, and costs to a CSV file with 3*aucTraits.numUnobsAucTypes columns
+    // While the threads work, save a checkpoint every checkpointInterval seconds and print the
+    // progress to stderr every progressInterval seconds
+    chrono::steady_clock::time_point lastCheckpoint = chrono::steady_clock::now();
+    chrono::steady_clock::time_point lastProgress = chrono::steady_clock::now();
+    while( threadsRunning.load() > 0 ){
+        this_thread::sleep_for(chrono::milliseconds(100));
+        if( (progressInterval > 0) &&
+            (chrono::steady_clock::now() - lastProgress >= chrono::seconds(progressInterval)) ){
+            runReport.printProgress();
+            lastProgress = chrono::steady_clock::now();
+        }
+        if( (checkpointInterval > 0) &&
+            (chrono::steady_clock::now() - lastCheckpoint >= chrono::seconds(checkpointInterval)) ){
+            writeCheckpoint(checkpointName.c_str(), checkpointFingerprint, finishedProgress(results, bidFinished));
+            lastCheckpoint = chrono::steady_clock::now();
+        }
+    }
+    for(int t = 0; t < numThreads; t++){
+        threads[t].join();
+    }
+    runReport.beginPhase("finish");
+
+    // Fill in the bids that reused other bids' simulations, and report how many did
+    if( settings.memoize ){
+        copyCanonicalResults(bids, simBids, canonicalBid, results);
+        size_t numReused = bids.size() - numUnique;
+        cout << "Memoization: " << numReused << " of " << bids.size() << " bids (" << 100.0 * numReused / max(bids.size(), (size_t)1)
+             << "%) reused the simulations of an earlier bid; " << numUnique << " were simulated\n";
+    }
+
+    // Check the tables against brute-force simulation
+    if( settings.ivTable != NULL ){
+        checkInclusiveValueTable(simBids, canonicalBid, aucTraits, settings, sampleBids, nlp, bidderTypeDist,
+                                 numBidDist, results, shard.firstRow, shard.endRow, 50);
+        delete settings.ivTable;
+    }
+
+    // In adaptive mode, report how much simulation the tolerance took
+    if( settings.adaptive ){
+        long long totalSims = 0;
+        long long numSimulated = 0;
+        for(int uAucType = 0; uAucType < aucTraits.numUnobsAucTypes; uAucType++){
+            for(size_t i = 0; i < bids.size(); i++){
+                if( results[uAucType][i].numSims > 0 ){
+                    totalSims += results[uAucType][i].numSims;
+                    numSimulated++;
+                }
+            }
+        }
+        if( numSimulated > 0 ){
+            cout << "Adaptive simulation used " << totalSims << " auctions, an average of "
+                 << (double) totalSims / numSimulated << " per bid and auction type\n";
+        }
+    }
+
+    // Write probabilities, derivatives, and costs to a CSV file with 3*aucTraits.numUnobsAucTypes
+    // columns.  Adaptive runs add the number of simulations and the cost's standard error after the
+    // cost of each type, for 5*aucTraits.numUnobsAucTypes columns.  A shard writes its header line,
+    // then the lines of its rows.
+    runReport.beginPhase("write_output");
     ofstream outputFile;
-    outputFile.open("estimated_costs.csv");
+    outputFile.open(outputName.c_str());
+    if( numShards > 0 ){
+        outputFile << formatShardHeader(shard) << "\n";
+    }
 
-    for(int i = 0; i < simulatedProb[0].size(); i++){
+    for(long long i = shard.firstRow; i < shard.endRow; i++){
         for(int uAucType = 0; uAucType < aucTraits.numUnobsAucTypes; uAucType++){
             if(uAucType > 0){
                 outputFile << ", ";
             }
-            outputFile << simulatedProb[uAucType][i] << ", " << simulatedProbDeriv[uAucType][i] << ", " <<
-                costs[uAucType][i];
+            const SimulationResult& result = results[uAucType][i];
+            outputFile << result.prob << ", " << result.probDer << ", " << result.cost;
+            if( settings.adaptive ){
+                outputFile << ", " << result.numSims << ", " << result.costSE;
+            }
         }
         outputFile << "\n";
     }
     outputFile.close();
+    // Keep the checkpoint if the output couldn't be written, so that the run can still be resumed
+    if( outputFile.fail() ){
+        cout << "Error: could not write " << outputName << "; the checkpoint is kept.\n";
+        return(1);
+    }
+
+    // The run is complete, so its checkpoint is no longer needed
+    remove(checkpointName.c_str());
+
+    // Percentile intervals of the costs from resampled auctions, reusing the sample bids and
+    // parameters already loaded
+    if( bootstrap.numReplicates > 0 ){
+        runReport.beginPhase("bootstrap");
+        bootstrap.seed = settings.seed;
+        cout << "Bootstrapping the costs with " << bootstrap.numReplicates << " replicates of "
+             << bootstrap.numSims << " simulations\n";
+        vector< vector<CostInterval> > intervals;
+        if( !bootstrapCosts(bids, aucTraits, bootstrap, sampleBids, nlp, numThreads, intervals) ||
+            !writeCostIntervals("estimated_costs_bootstrap.csv", intervals) ){
+            return(1);
+        }
+    }
+
+    // Summarize the run
+    runReport.endPhase();
+    if( reportFile != NULL ){
+        runReport.setInfo("threads", numThreads);
+        runReport.setInfo("kernel", nestedLogitKernelName());
+        runReport.setInfo("bids", bids.size());
+        runReport.setInfo("bids_to_simulate", numToSimulate);
+        runReport.setInfo("sims_per_bid", settings.numAucSims);
+        runReport.setInfo("seed", to_string(settings.seed));
+        if( bootstrap.numReplicates > 0 ){
+            runReport.setInfo("bootstrap_replicates", bootstrap.numReplicates);
+        }
+        if( numShards > 0 ){
+            runReport.setInfo("shard", to_string(shardIndex) + "/" + to_string(numShards));
+        }
+        if( !runReport.writeJson(reportFile) ){
+            return(1);
+        }
+    }
 
     
     // Program finished execution: return normal exit code 0
@@ -0,0 +1,109 @@
+// checkpoint.cpp
+// Reading and writing the checkpoints declared in checkpoint.hpp
+
+#include "checkpoint.hpp"
+
+
+using namespace std;
+
+
+// A checkpoint file is a header, one byte per bid saying whether it is finished, then the results
+// of every unobserved auction type in turn (one per bid, unfinished bids zeroed), in native byte order
+
+static const char checkpointMagic[8] = {'B', 'C', 'A', 'C', 'K', 'P', 'T', '\0'};
+static const uint32_t checkpointVersion = 1;
+
+typedef struct {
+    char magic[8];           // checkpointMagic
+    uint32_t version;        // checkpointVersion
+    uint32_t numUnobsAucTypes;
+    uint64_t numBids;
+    uint64_t numDone;        // finished bids
+    uint64_t firstUnfinished; // every bid before this one is finished
+    uint64_t fingerprint;    // hash of the run's settings and inputs
+    uint64_t bodyChecksum;   // hash of everything after the header
+} CheckpointHeader;
+
+
+// Checksum of the body: the finished flags, then the results of each type
+static uint64_t bodyChecksum(const CostProgress& progress){
+    uint64_t hash = hashBytes(progress.bidDone.data(), progress.bidDone.size(), fnvOffsetBasis);
+    for(size_t k = 0; k < progress.results.size(); k++){
+        hash = hashBytes(progress.results[k].data(), progress.results[k].size()*sizeof(SimulationResult), hash);
+    }
+    return( hash );
+}
+
+
+// Write to a temporary file and rename it over the old checkpoint, so that a crash while writing
+// leaves the previous checkpoint intact
+bool writeCheckpoint(const char *fileName, uint64_t fingerprint, const CostProgress& progress){
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, checkpointMagic, sizeof(header.magic));
+    header.version = checkpointVersion;
+    header.numUnobsAucTypes = progress.results.size();
+    header.numBids = progress.bidDone.size();
+    header.numDone = count(progress.bidDone.begin(), progress.bidDone.end(), 1);
+    header.firstUnfinished = find(progress.bidDone.begin(), progress.bidDone.end(), 0) - progress.bidDone.begin();
+    header.fingerprint = fingerprint;
+    header.bodyChecksum = bodyChecksum(progress);
+
+    string tempName = string(fileName) + ".tmp";
+    FILE *checkpointFile = fopen(tempName.c_str(), "wb");
+    if( checkpointFile == NULL ){
+        cout << "Error: could not open " << tempName << " for writing.\n";
+        return( false );
+    }
+    bool ok = (fwrite(&header, sizeof(header), 1, checkpointFile) == 1) &&
+        (fwrite(progress.bidDone.data(), 1, progress.bidDone.size(), checkpointFile) == progress.bidDone.size());
+    for(size_t k = 0; k < progress.results.size(); k++){
+        ok = ok && (fwrite(progress.results[k].data(), sizeof(SimulationResult), progress.results[k].size(),
+                           checkpointFile) == progress.results[k].size());
+    }
+    ok = (fclose(checkpointFile) == 0) && ok;
+    ok = ok && (rename(tempName.c_str(), fileName) == 0);
+    if( !ok ){
+        cout << "Error: could not write checkpoint " << fileName << ".\n";
+    }
+    return( ok );
+}
+
+
+bool readCheckpoint(const char *fileName, uint64_t fingerprint, CostProgress& progress){
+
+    FILE *checkpointFile = fopen(fileName, "rb");
+    if( checkpointFile == NULL ){
+        cout << "Error: could not open checkpoint " << fileName << ".\n";
+        return( false );
+    }
+
+    CheckpointHeader header;
+    const char *problem = NULL;
+    if( (fread(&header, sizeof(header), 1, checkpointFile) != 1) ||
+        (memcmp(header.magic, checkpointMagic, sizeof(header.magic)) != 0) ){
+        problem = "is not a checkpoint";
+    } else if( header.version != checkpointVersion ){
+        problem = "was written by a different version of calculate_costs";
+    } else if( (header.fingerprint != fingerprint) || (header.numBids != progress.bidDone.size()) ||
+               (header.numUnobsAucTypes != progress.results.size()) ){
+        problem = "was written by a run with different settings or inputs";
+    } else {
+        bool ok = (fread(progress.bidDone.data(), 1, progress.bidDone.size(), checkpointFile) == progress.bidDone.size());
+        for(size_t k = 0; k < progress.results.size(); k++){
+            ok = ok && (fread(progress.results[k].data(), sizeof(SimulationResult), progress.results[k].size(),
+                              checkpointFile) == progress.results[k].size());
+        }
+        if( !ok || (fgetc(checkpointFile) != EOF) || (bodyChecksum(progress) != header.bodyChecksum) ){
+            problem = "is damaged";
+        }
+    }
+    fclose(checkpointFile);
+
+    if( problem != NULL ){
+        cout << "Error: checkpoint " << fileName << " " << problem << ".\n";
+        return( false );
+    }
+    return( true );
+}
@@ -0,0 +1,45 @@
+// checkpoint.hpp
+// Checkpoints of a calculate_costs.exe run: which bids are finished and their results, so that an
+// interrupted run can pick up where it stopped.  Every simulation draws from a stream keyed by the
+// seed, bid, auction type, and simulation index, so the position of the random number generator is
+// fully described by the settings: a resumed run simulates the unfinished bids exactly as the
+// uninterrupted run would have, and its output is identical.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef CHECKPOINT_INCLUDED
+#define CHECKPOINT_INCLUDED
+
+#include <stdint.h>
+#include "bid_selection.hpp"
+
+
+// Progress of a run: results[uAucType][bid] is final once bidDone[bid] is nonzero
+typedef struct {
+    std::vector< std::vector<SimulationResult> > results;
+    std::vector<char> bidDone;
+} CostProgress;
+
+// 64-bit FNV-1a hash of a block of bytes, continuing from hash (start from fnvOffsetBasis).  Used
+// to fingerprint the settings and inputs of a run so that a checkpoint is only resumed by a run
+// that would produce the same results, and by the other code that checksums its inputs.  Defined
+// here so that programs without checkpoints can use it without linking checkpoint.cpp.
+const uint64_t fnvOffsetBasis = 0xCBF29CE484222325ULL;
+inline uint64_t hashBytes(const void *data, size_t numBytes, uint64_t hash){
+    const unsigned char *bytes = (const unsigned char*)data;
+    for(size_t i = 0; i < numBytes; i++){
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    return( hash );
+}
+
+// Save the progress, replacing fileName only once the new checkpoint is completely written.
+// Returns false (after printing an error) if it can't be written.
+bool writeCheckpoint(const char *fileName, uint64_t fingerprint, const CostProgress& progress);
+// Load the progress saved in fileName into progress, which must already have the run's dimensions.
+// Returns false (after printing an error) if the file is missing, damaged, or was written by a run
+// with a different fingerprint or dimensions.
+bool readCheckpoint(const char *fileName, uint64_t fingerprint, CostProgress& progress);
+
+
+// End header guard with endif statement
+#endif
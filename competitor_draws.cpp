@@ -0,0 +1,110 @@
+// competitor_draws.cpp
+// Implementing the banks of simulated competitors declared in competitor_draws.hpp
+
+#include "competitor_draws.hpp"
+#include "random_streams.hpp"
+#include <assert.h>
+#include <algorithm>
+
+
+using namespace std;
+
+
+// Empty the bank
+void CompetitorDraws::reset(int firstSim){
+    bankFirstSim = firstSim;
+    offsets.clear();
+    bidTypeDraws.clear();
+    rowDraws.clear();
+    maxCompetitors = 0;
+    offsets.push_back(0);
+}
+
+
+// Stream index of the digital shifts for Sobol draws (simulation indices never reach it)
+static const uint32_t shiftStream = 0xFFFFFFFF;
+
+// Fill the uniforms of one simulation, one per dimension
+void CompetitorDraws::fillUniforms(uint64_t seed, uint64_t streamBid, uint32_t streamType, int sim,
+                                   const vector<uint32_t>& shifts){
+
+    if( mode == sobolDraws ){
+        for(size_t dim = 0; dim < uniforms.size(); dim++){
+            uniforms[dim] = (sobol->point(sim, dim) ^ shifts[dim]) * (1.0 / 4294967296.0);
+        }
+        return;
+    }
+
+    // Antithetic: both simulations of a pair read the stream of the even one; the odd one mirrors
+    // each uniform, staying below 1 for the alias tables and row indices
+    RandomStream draws(seed, streamBid, streamType, sim & ~1);
+    for(size_t dim = 0; dim < uniforms.size(); dim++){
+        uniforms[dim] = draws.nextUniform();
+        if( sim & 1 ){
+            uniforms[dim] = min(1 - uniforms[dim], 1 - 1.0/9007199254740992.0);
+        }
+    }
+}
+
+
+// Draw the competitors for the next numSims simulations
+void CompetitorDraws::extend(uint64_t seed, uint64_t streamBid, uint32_t streamType, int numSims,
+                             const AliasTable& numBidTable, const AliasTable& bidderTypeTable, int numSamples){
+
+    int firstSim = bankFirstSim + this->numSims();
+
+    // Sobol and antithetic draws: uniforms laid out by dimension
+    if( mode != prngDraws ){
+
+        int numDims = numBidTable.size();
+        uniforms.resize(1 + 2*numDims);
+        // Each stream of simulations gets its own digital shift of the Sobol sequence
+        vector<uint32_t> shifts;
+        if( mode == sobolDraws ){
+            assert( sobol->numDims() >= (int)uniforms.size() );
+            RandomStream shiftDraws(seed, streamBid, streamType, shiftStream);
+            for(size_t dim = 0; dim < uniforms.size(); dim++){
+                shifts.push_back( (uint32_t)(shiftDraws.nextUniform() * 4294967296.0) );
+            }
+        }
+
+        for(int sim = firstSim; sim < firstSim + numSims; sim++){
+
+            fillUniforms(seed, streamBid, streamType, sim, shifts);
+
+            int numOtherBids = numBidTable.draw( uniforms[0] ) + 1;
+            maxCompetitors = max(maxCompetitors, numOtherBids);
+            for(int i = 0; i < numOtherBids; i++){
+                bidTypeDraws.push_back( bidderTypeTable.draw( uniforms[1 + i] ) );
+            }
+            for(int i = 0; i < numOtherBids; i++){
+                int row = (int)(uniforms[1 + numDims + i] * numSamples);
+                rowDraws.push_back( row < numSamples ? row : numSamples - 1 );
+            }
+            offsets.push_back( bidTypeDraws.size() );
+        }
+        return;
+    }
+
+    // Pseudo-random draws: each simulation reads its own stream in order
+    for(int sim = firstSim; sim < firstSim + numSims; sim++){
+
+        RandomStream draws(seed, streamBid, streamType, sim);
+
+        // Draw a random number of other bidders (outcome 0 means one other bid)
+        int numOtherBids = numBidTable.draw( draws.nextUniform() ) + 1;
+        maxCompetitors = max(maxCompetitors, numOtherBids);
+
+        // For all other bids, draw a random bidder type (indexed from 0)
+        for(int i = 0; i < numOtherBids; i++){
+            bidTypeDraws.push_back( bidderTypeTable.draw( draws.nextUniform() ) );
+        }
+
+        // Then draw the row of the sample bid for each competitor, from {0, ..., numSamples - 1}
+        for(int i = 0; i < numOtherBids; i++){
+            rowDraws.push_back( draws.nextIndex(numSamples) );
+        }
+
+        offsets.push_back( bidTypeDraws.size() );
+    }
+}
@@ -0,0 +1,122 @@
+// competitor_draws.hpp
+// Banks of simulated competitors: the number of other bids, their bidder types, and the sample bid
+// row of each, for a range of simulated auctions.  None of these draws depend on the unobserved
+// auction type (which only picks the sample bid cell the rows refer to), so one bank can be shared
+// across unobserved types, or across every bid with the same observed auction type, giving common
+// random numbers for the cost comparisons.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef COMPETITOR_DRAWS_INCLUDED
+#define COMPETITOR_DRAWS_INCLUDED
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "alias_table.hpp"
+#include "sobol_sequence.hpp"
+
+
+// Which simulations share their competitor draws
+//   independentDraws: every (bid, unobserved type) pair gets its own draws
+//   commonAcrossTypes: all unobserved types of a bid share draws
+//   commonAcrossBids: all bids with the same observed auction type (and all unobserved types) share draws
+enum CommonDrawMode { independentDraws, commonAcrossTypes, commonAcrossBids };
+
+// Where the uniforms behind the competitor draws come from
+//   prngDraws: a pseudo-random stream for each simulation
+//   sobolDraws: point i of a Sobol sequence for simulation i, with a random digital shift for each
+//               stream of simulations
+//   antitheticDraws: pseudo-random streams for even simulations; each odd simulation uses one minus
+//                    the uniforms of the simulation before it
+enum DrawMode { prngDraws, sobolDraws, antitheticDraws };
+
+
+class CompetitorDraws {
+
+public:
+
+    // Start with an empty bank
+    CompetitorDraws(){
+        mode = prngDraws;
+        sobol = NULL;
+        reset(0);
+    }
+
+    // Choose where the uniforms come from (pseudo-random by default).  Sobol draws need a sequence
+    // with at least 1 + 2*(largest number of other bids) dimensions.
+    void setDrawMode(DrawMode drawMode, const SobolSequence *sobolSequence){
+        mode = drawMode;
+        sobol = sobolSequence;
+    }
+
+    // Empty the bank; the next simulation appended will be simulation firstSim.  Storage is kept,
+    // so refilling a bank of the same size doesn't allocate.
+    void reset(int firstSim);
+
+    // Append the competitors of the next numSims simulations.  Simulation i draws from the stream
+    // keyed by (seed, streamBid, streamType, i): its number of other bids, then the bidder type of
+    // each, then the sample row of each.  With Sobol or antithetic draws the uniforms are laid out
+    // by dimension instead: the number of other bids in dimension 0, the bidder type of competitor k
+    // in dimension 1 + k, and its row in dimension 1 + K + k, where K is the largest number of
+    // other bids, so that every simulation uses the same dimension for the same draw.
+    void extend(uint64_t seed, uint64_t streamBid, uint32_t streamType, int numSims,
+                const AliasTable& numBidTable, const AliasTable& bidderTypeTable, int numSamples);
+
+    // Replace the bank with the competitors of simulations firstSim, ..., firstSim + numSims - 1
+    void draw(uint64_t seed, uint64_t streamBid, uint32_t streamType, int firstSim, int numSims,
+              const AliasTable& numBidTable, const AliasTable& bidderTypeTable, int numSamples){
+        reset(firstSim);
+        extend(seed, streamBid, streamType, numSims, numBidTable, bidderTypeTable, numSamples);
+    }
+
+    // First simulation in the bank
+    int firstSim() const {
+        return( bankFirstSim );
+    }
+    // Number of simulations in the bank
+    int numSims() const {
+        return( offsets.size() - 1 );
+    }
+    // Competitors of simulation sim (counted from the start of the bank)
+    int numOtherBids(int sim) const {
+        return( offsets[sim + 1] - offsets[sim] );
+    }
+    // Bidder types (indexed from 0) and sample rows of the competitors of simulation sim
+    const int *bidTypes(int sim) const {
+        return( bidTypeDraws.data() + offsets[sim] );
+    }
+    const int *rows(int sim) const {
+        return( rowDraws.data() + offsets[sim] );
+    }
+    // Total competitors of simulations sim, ..., sim + count - 1 (counted from the start of the bank)
+    int numCompetitors(int sim, int count) const {
+        return( offsets[sim + count] - offsets[sim] );
+    }
+    // Largest number of competitors in any simulation in the bank
+    int maxOtherBids() const {
+        return( maxCompetitors );
+    }
+
+private:
+
+    // Simulation drawn first, and the competitors of the bank's simulation i are entries
+    // offsets[i], ..., offsets[i + 1] - 1
+    int bankFirstSim;
+    std::vector<int> offsets;
+    std::vector<int> bidTypeDraws;
+    std::vector<int> rowDraws;
+    int maxCompetitors;
+
+    // Source of the uniforms, and space for the uniforms of one simulation
+    DrawMode mode;
+    const SobolSequence *sobol;
+    std::vector<double> uniforms;
+
+    // Fill uniforms with the 1 + 2*numDims uniforms of simulation sim in Sobol or antithetic mode
+    void fillUniforms(uint64_t seed, uint64_t streamBid, uint32_t streamType, int sim,
+                      const std::vector<uint32_t>& shifts);
+};
+
+
+// End header guard with endif statement
+#endif
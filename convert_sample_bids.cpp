@@ -0,0 +1,88 @@
+// convert_sample_bids.cpp
+// Convert the sample_bids_*.csv files into one binary cache file that calculate_costs.exe can map
+// instead of parsing the CSV files on every run (see sample_bid_store.hpp for the format), and write
+// the manifest of the sample bid files that the importer reads (see import_data.hpp)
+// Compiled as: g++ -O2 -pthread -o convert_sample_bids.exe convert_sample_bids.cpp import_data.cpp alias_table.cpp sample_bid_store.cpp
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "import_data.hpp"
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+// Command line options:
+//   --num-samples N   sample bids to import from each sample bid file (default 10000)
+//   --output FILE     name of the cache file (default sample_bids.bin)
+//   --manifest FILE   name of the manifest of the sample bid files (default sample_bids_manifest.txt)
+//   --write-manifest  find the sample bid files in the working directory and write the manifest
+//                     before converting (run once after the sample bids are written)
+//   --threads N       read N files at a time (default 0, every available core)
+int main(int argc, char *argv[]){
+
+    // Read command line options
+    int numSamples = 10000;
+    const char *outputFile = "sample_bids.bin";
+    const char *manifestFile = sampleBidManifestFile;
+    bool writeManifest = false;
+    int numThreads = 0;
+    for(int i = 1; i < argc; i++){
+        if( (strcmp(argv[i], "--num-samples") == 0) && (i + 1 < argc) ){
+            numSamples = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--output") == 0) && (i + 1 < argc) ){
+            outputFile = argv[++i];
+        } else if( (strcmp(argv[i], "--manifest") == 0) && (i + 1 < argc) ){
+            manifestFile = argv[++i];
+        } else if( strcmp(argv[i], "--write-manifest") == 0 ){
+            writeManifest = true;
+        } else if( (strcmp(argv[i], "--threads") == 0) && (i + 1 < argc) ){
+            numThreads = atoi(argv[++i]);
+        } else {
+            cout << "Error: unrecognized option " << argv[i] << ".\n";
+            cout << "Usage: convert_sample_bids.exe [--num-samples N] [--output FILE] [--manifest FILE]"
+                 << " [--write-manifest] [--threads N]\n";
+            return(1);
+        }
+    }
+    if( numSamples <= 0 ){
+        cout << "Error: --num-samples must be positive.\n";
+        return(1);
+    }
+    if( numThreads <= 0 ){
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+
+    // List the sample bid files once, checking that no type cell is missing, and record their sizes
+    // and checksums
+    if( writeManifest ){
+        AucTraits aucTraits;
+        if( !findSampleBidTypes(aucTraits) || !writeSampleBidManifest(manifestFile, aucTraits, numThreads) ){
+            return(1);
+        }
+        cout << "Wrote " << manifestFile << " for " << aucTraits.numBidderTypes << " bidder types, "
+             << aucTraits.numObsAucTypes << " observed auction types, and " << aucTraits.numUnobsAucTypes
+             << " unobserved auction types\n";
+    }
+
+    // Import the sample bids of the cells in the manifest, as calculate_costs.exe would
+    SampleBidManifest manifest;
+    if( !readSampleBidManifest(manifestFile, manifest) ){
+        return(1);
+    }
+    SampleBidStore sampleBids(manifest.aucTraits, numSamples);
+    if( !importSampleBids(sampleBids, manifest, numThreads) ){
+        return(1);
+    }
+
+    // Map the cache back and check its checksums once here, so that calculate_costs.exe only has to
+    // check the header
+    SampleBidStore written;
+    if( !sampleBids.writeCache(outputFile) || !written.mapCache(outputFile, numSamples, true) ){
+        return(1);
+    }
+    cout << "Wrote " << sampleBids.numCells() << " cells of " << numSamples << " sample bids to "
+         << outputFile << "\n";
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+// cost_bootstrap.cpp
+// Implementing the bootstrap intervals declared in cost_bootstrap.hpp
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "cost_bootstrap.hpp"
+#include "auction_type_probs.hpp"
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+// Stream type of the resampling draws, distinct from the unobserved auction types that key the
+// simulations' streams and from the other reserved stream types
+static const uint32_t resampleStream = 0xFFFFFFFC;
+
+
+// Quantile p of sorted values, interpolating linearly between the order statistics
+static double sortedQuantile(const vector<double>& sorted, double p){
+    double position = p*(sorted.size() - 1);
+    size_t below = (size_t)position;
+    if( below + 1 >= sorted.size() ){
+        return( sorted.back() );
+    }
+    return( sorted[below] + (position - below)*(sorted[below + 1] - sorted[below]) );
+}
+
+// Alias tables of each row of shares.  Rows the resample has no auctions for (NaN) use the
+// corresponding row of the data instead, and rows the data has none for are uniform (no bid draws
+// from them).
+static vector<AliasTable> shareTables(const vector< vector<double> >& shares, const vector< vector<double> >& dataShares){
+    vector<AliasTable> tables;
+    for(size_t row = 0; row < shares.size(); row++){
+        if( !isnan(shares[row][0]) ){
+            tables.push_back( AliasTable(shares[row]) );
+        } else if( !isnan(dataShares[row][0]) ){
+            tables.push_back( AliasTable(dataShares[row]) );
+        } else {
+            tables.push_back( AliasTable(vector<double>(shares[row].size(), 1)) );
+        }
+    }
+    return( tables );
+}
+
+
+bool bootstrapCosts(const vector<Bid>& bids, AucTraits aucTraits, const BootstrapSettings& settings,
+                    const SampleBidStore& sampleBids, const BidSelectionParams& nlp, int numThreads,
+                    vector< vector<CostInterval> >& intervals){
+
+    // The auctions, without the outside option, as calc_auction_type_probs.exe groups them
+    vector<Bid> dataBids;
+    for(size_t i = 0; i < bids.size(); i++){
+        if( bids[i].bidderType == 0 ){
+            continue;
+        }
+        if( (bids[i].bidderType < 1) || (bids[i].bidderType > aucTraits.numBidderTypes) ||
+            (bids[i].obsAucType < 1) || (bids[i].obsAucType > aucTraits.numObsAucTypes) ){
+            cout << "Error: bid " << i + 1 << " has bidder type " << bids[i].bidderType << " and observed auction type "
+                 << bids[i].obsAucType << ", outside the types of the sample bids.\n";
+            return( false );
+        }
+        dataBids.push_back(bids[i]);
+    }
+    if( dataBids.empty() ){
+        cout << "Error: there are no bids other than the outside option to resample.\n";
+        return( false );
+    }
+    AuctionIndex index = indexAuctions(dataBids);
+    size_t numAuctions = index.auctionStart.size() - 1;
+    vector<double> dataWeights(numAuctions, 1);
+    vector< vector<double> > dataNumBids = numBidDistribution(dataBids, index, aucTraits, dataWeights);
+    vector< vector<double> > dataBidderTypes = bidderTypeDistribution(dataBids, index, aucTraits, dataWeights);
+
+    // Distributions of each replicate, from numAuctions auctions drawn with replacement
+    int R = settings.numReplicates;
+    vector< vector<AliasTable> > numBidTables;
+    vector< vector<AliasTable> > bidderTypeTables;
+    for(int r = 0; r < R; r++){
+        RandomStream draws(settings.seed, r, resampleStream, 0);
+        vector<double> auctionWeights(numAuctions, 0);
+        for(size_t n = 0; n < numAuctions; n++){
+            auctionWeights[draws.nextIndex(numAuctions)]++;
+        }
+        numBidTables.push_back( shareTables(numBidDistribution(dataBids, index, aucTraits, auctionWeights), dataNumBids) );
+        bidderTypeTables.push_back( shareTables(bidderTypeDistribution(dataBids, index, aucTraits, auctionWeights),
+                                                dataBidderTypes) );
+    }
+
+    // Each thread takes the next bid and estimates its cost in every replicate and type
+    int K = aucTraits.numUnobsAucTypes;
+    intervals.assign(K, vector<CostInterval>(bids.size()));
+    double tail = (1 - settings.level) / 2;
+    atomic<size_t> nextBid(0);
+    auto worker = [&](){
+        AuctionScratch scratch(numBidTables[0]);
+        CompetitorDraws draws;
+        vector<double> costs;
+        for(size_t i = nextBid.fetch_add(1); i < bids.size(); i = nextBid.fetch_add(1)){
+            if( bids[i].bidderType == 0 ){
+                CostInterval placeholder = {-99, -99};
+                for(int k = 0; k < K; k++){
+                    intervals[k][i] = placeholder;
+                }
+                continue;
+            }
+            int obsAucType = bids[i].obsAucType - 1;
+            for(int k = 0; k < K; k++){
+                costs.clear();
+                for(int r = 0; r < R; r++){
+                    draws.draw(settings.seed, i, k, 0, settings.numSims, numBidTables[r][obsAucType],
+                               bidderTypeTables[r][obsAucType], sampleBids.numSamples());
+                    SimulationSums sums = simulateAuctions(bids[i], k, draws, 0, settings.numSims, sampleBids, nlp, scratch);
+                    double cost = bids[i].amount + sums.probSum / sums.probDerSum;
+                    // A replicate whose simulations give a zero derivative has no cost
+                    if( isfinite(cost) ){
+                        costs.push_back(cost);
+                    }
+                }
+                if( costs.empty() ){
+                    CostInterval missing = {NAN, NAN};
+                    intervals[k][i] = missing;
+                    continue;
+                }
+                sort(costs.begin(), costs.end());
+                CostInterval interval = {sortedQuantile(costs, tail), sortedQuantile(costs, 1 - tail)};
+                intervals[k][i] = interval;
+            }
+        }
+    };
+    vector<thread> threads;
+    for(int t = 1; t < numThreads; t++){
+        threads.push_back( thread(worker) );
+    }
+    worker();
+    for(size_t t = 0; t < threads.size(); t++){
+        threads[t].join();
+    }
+    return( true );
+}
+
+
+bool writeCostIntervals(const char *fileName, const vector< vector<CostInterval> >& intervals){
+
+    ofstream outputFile(fileName);
+    if( !outputFile.is_open() ){
+        cout << "Error: could not write " << fileName << ".\n";
+        return( false );
+    }
+    for(size_t i = 0; i < intervals[0].size(); i++){
+        for(size_t k = 0; k < intervals.size(); k++){
+            if( k > 0 ){
+                outputFile << ", ";
+            }
+            outputFile << intervals[k][i].lower << ", " << intervals[k][i].upper;
+        }
+        outputFile << "\n";
+    }
+    outputFile.close();
+    if( outputFile.fail() ){
+        cout << "Error: could not finish writing " << fileName << ".\n";
+        return( false );
+    }
+    return( true );
+}
@@ -0,0 +1,51 @@
+// cost_bootstrap.hpp
+// Bootstrap percentile intervals for the costs in estimated_costs.csv.  Each replicate resamples
+// the auctions of template_data.csv with replacement and recomputes the distributions of the
+// number of bids and of bidder types from the resample (as calc_auction_type_probs.exe computes
+// them from the data), then re-estimates every bid's cost in every unobserved auction type against
+// those distributions.  The sample bids and selection model coefficients are the ones already
+// loaded, so the intervals reflect the sampling error of the auction distributions.
+// Every replicate draws the competitors of a bid and type from the same streams (seed, bid, type,
+// simulation), so the replicates share their uniforms and differ only where their distributions
+// do: the spread across replicates is the bootstrap variation rather than new simulation noise,
+// and fewer simulations per replicate are needed than for the point estimates.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef COST_BOOTSTRAP_INCLUDED
+#define COST_BOOTSTRAP_INCLUDED
+
+#include <stdint.h>
+#include <vector>
+#include "bid_selection.hpp"
+#include "sample_bid_store.hpp"
+
+
+// Settings of the bootstrap
+typedef struct {
+    int numReplicates;  // resamples of the auctions
+    int numSims;        // simulated auctions per bid, unobserved type, and replicate
+    double level;       // coverage of the intervals (0.95 gives the 2.5th and 97.5th percentiles)
+    uint64_t seed;      // seed of the resamples and of the simulations
+} BootstrapSettings;
+
+// Percentile interval of one bid's cost in one unobserved auction type
+typedef struct {
+    double lower;
+    double upper;
+} CostInterval;
+
+// Fill intervals[uAucType][i] for every bid, using numThreads threads (each takes the next bid and
+// runs all its replicates, so the results don't depend on the number of threads).  Outside option
+// bids get -99, as in estimated_costs.csv.  Returns false (after printing an error) if a bid's types
+// are outside aucTraits.
+bool bootstrapCosts(const std::vector<Bid>& bids, AucTraits aucTraits, const BootstrapSettings& settings,
+                    const SampleBidStore& sampleBids, const BidSelectionParams& nlp, int numThreads,
+                    std::vector< std::vector<CostInterval> >& intervals);
+
+// Write the intervals of each bid as a row of "lower, upper" pairs, one pair per unobserved auction
+// type.  Returns false (after printing an error) if the file can't be written.
+bool writeCostIntervals(const char *fileName, const std::vector< std::vector<CostInterval> >& intervals);
+
+
+// End header guard with endif statement
+#endif
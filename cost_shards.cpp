@@ -0,0 +1,50 @@
+// cost_shards.cpp
+// Implementing the shard ranges and headers declared in cost_shards.hpp
+
+#include "cost_shards.hpp"
+#include <stdio.h>
+
+// Use standard namespace: can call string rather than std::string
+using namespace std;
+
+
+bool parseShardOption(const char *option, int& index, int& numShards){
+    int length = 0;
+    if( (sscanf(option, "%d/%d%n", &index, &numShards, &length) != 2) || (option[length] != '\0') ){
+        return( false );
+    }
+    return( (numShards >= 1) && (index >= 1) && (index <= numShards) );
+}
+
+
+// Shard i starts at floor((i - 1)*totalRows/numShards), so the sizes differ by at most one row and
+// the ranges of shards 1, ..., numShards cover every row once
+void shardRows(long long totalRows, int index, int numShards, long long& firstRow, long long& endRow){
+    firstRow = (index - 1) * totalRows / numShards;
+    endRow = index * totalRows / numShards;
+}
+
+
+string shardFileName(const char *baseName, const char *extension, int index, int numShards){
+    char fileName[1000];
+    snprintf(fileName, sizeof(fileName), "%s.shard_%d_of_%d.%s", baseName, index, numShards, extension);
+    return( string(fileName) );
+}
+
+
+string formatShardHeader(const ShardHeader& header){
+    char line[200];
+    snprintf(line, sizeof(line), "# shard %d/%d rows %lld-%lld of %lld seed %llu fingerprint %016llx", header.index,
+             header.numShards, header.firstRow, header.endRow, header.totalRows, (unsigned long long)header.seed,
+             (unsigned long long)header.fingerprint);
+    return( string(line) );
+}
+
+bool parseShardHeader(const char *line, ShardHeader& header){
+    unsigned long long seed, fingerprint;
+    int numRead = sscanf(line, "# shard %d/%d rows %lld-%lld of %lld seed %llu fingerprint %llx", &header.index,
+                         &header.numShards, &header.firstRow, &header.endRow, &header.totalRows, &seed, &fingerprint);
+    header.seed = seed;
+    header.fingerprint = fingerprint;
+    return( numRead == 7 );
+}
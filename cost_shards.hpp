@@ -0,0 +1,47 @@
+// cost_shards.hpp
+// Splitting a calculate_costs.exe run across processes.  calculate_costs.exe --shard i/N simulates
+// only the i-th of N ranges of rows of template_data.csv and writes their lines of
+// estimated_costs.csv to estimated_costs.shard_i_of_N.csv, after a one-line header:
+//   # shard 2/4 rows 76-152 of 304 seed 1 fingerprint 0123456789abcdef
+// The rows are counted from 0 and the range excludes its end.  Every simulation's random stream is
+// keyed by the bid's row in the whole file, not in the shard, so each shard's lines are exactly the
+// ones a single run would write, and merge_cost_shards.exe stitches the shards back into that file.
+// The fingerprint covers the settings and inputs (see runFingerprint() in calculate_costs.cpp), so
+// shards from different runs can't be mixed.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef COST_SHARDS_INCLUDED
+#define COST_SHARDS_INCLUDED
+
+#include <stdint.h>
+#include <string>
+
+
+// Which rows a shard covers, and the run it belongs to
+typedef struct {
+    int index;             // shard number, from 1 to numShards
+    int numShards;
+    long long firstRow;    // first row of template_data.csv in the shard (counted from 0)
+    long long endRow;      // one past the last row in the shard
+    long long totalRows;   // rows in template_data.csv
+    uint64_t seed;
+    uint64_t fingerprint;
+} ShardHeader;
+
+// Read "i/N" from the --shard option.  Returns false if it isn't of that form with 1 <= i <= N.
+bool parseShardOption(const char *option, int& index, int& numShards);
+
+// Rows of shard index of numShards: the rows are split as evenly as possible, in order
+void shardRows(long long totalRows, int index, int numShards, long long& firstRow, long long& endRow);
+
+// Name of the output file of a shard, e.g. estimated_costs.shard_2_of_4.csv
+std::string shardFileName(const char *baseName, const char *extension, int index, int numShards);
+
+// The header line of a shard's output (without the newline), and reading it back.  parseShardHeader()
+// returns false if the line isn't a shard header.
+std::string formatShardHeader(const ShardHeader& header);
+bool parseShardHeader(const char *line, ShardHeader& header);
+
+
+// End header guard with endif statement
+#endif
@@ -0,0 +1,138 @@
+// generate_synthetic_data.cpp
+// Generate a complete set of inputs for calculate_costs.exe (see synthetic_data.hpp), so that the
+// cost estimation can be tested and timed at any scale without running the MATLAB and Stata stages
+// Compiled as: g++ -O2 -pthread -o generate_synthetic_data.exe generate_synthetic_data.cpp synthetic_data.cpp import_data.cpp alias_table.cpp
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "synthetic_data.hpp"
+#include <chrono> // For the time taken
+#include <unistd.h> // For chdir()
+#include <sys/stat.h> // For mkdir()
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+// Read the eight comma-separated coefficients of coeff.txt, in its order, into params.  Returns
+// false if there aren't exactly eight numbers.
+bool parseCoefficients(const char *text, BidSelectionParams& params){
+    double values[8];
+    int numRead = 0;
+    const char *position = text;
+    while( numRead < 8 ){
+        char *end;
+        values[numRead] = strtod(position, &end);
+        if( end == position ){
+            return( false );
+        }
+        numRead++;
+        position = end;
+        if( *position != ',' ){
+            break;
+        }
+        position++;
+    }
+    if( (numRead != 8) || (*position != '\0') ){
+        return( false );
+    }
+    // Same columns as getBidSelectionParams(); c7 isn't used
+    params.bidAmountCoeff = values[0];
+    params.sellRepCoeff = values[1];
+    params.lnnumrepsCoeff = values[2];
+    params.buyrepCoeff = values[3];
+    params.lnprevcancelCoeff = values[4];
+    params.nestConstant = values[5];
+    params.nestCorr = values[7];
+    return( true );
+}
+
+
+// Command line options:
+//   --bids N               bids in template_data.csv, not counting outside options (default 100000)
+//   --bidder-types N       number of bidder types (default 3)
+//   --obs-types N          number of observed auction types (default 2)
+//   --unobs-types N        number of unobserved auction types (default 2)
+//   --max-auction-size N   largest number of bids in an auction (default 6)
+//   --num-samples N        rows in each sample bid file (default 10000)
+//   --coeffs c1,...,c8     selection model coefficients in the order of coeff.txt
+//                          (default -0.02,0.3,0.1,0.05,-0.2,1.5,1,0.7)
+//   --seed S               seed for the random draws (default 1)
+//   --dir DIR              directory for the files, created if needed (default synthetic_data)
+int main(int argc, char *argv[]){
+
+    // Read command line options
+    SyntheticDataParams params;
+    params.seed = 1;
+    params.numBids = 100000;
+    params.aucTraits.numBidderTypes = 3;
+    params.aucTraits.numObsAucTypes = 2;
+    params.aucTraits.numUnobsAucTypes = 2;
+    params.maxAuctionSize = 6;
+    params.numSamples = 10000;
+    parseCoefficients("-0.02,0.3,0.1,0.05,-0.2,1.5,1,0.7", params.coeffs);
+    const char *outputDir = "synthetic_data";
+    for(int i = 1; i < argc; i++){
+        if( (strcmp(argv[i], "--bids") == 0) && (i + 1 < argc) ){
+            params.numBids = atoll(argv[++i]);
+        } else if( (strcmp(argv[i], "--bidder-types") == 0) && (i + 1 < argc) ){
+            params.aucTraits.numBidderTypes = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--obs-types") == 0) && (i + 1 < argc) ){
+            params.aucTraits.numObsAucTypes = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--unobs-types") == 0) && (i + 1 < argc) ){
+            params.aucTraits.numUnobsAucTypes = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--max-auction-size") == 0) && (i + 1 < argc) ){
+            params.maxAuctionSize = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--num-samples") == 0) && (i + 1 < argc) ){
+            params.numSamples = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--coeffs") == 0) && (i + 1 < argc) ){
+            if( !parseCoefficients(argv[++i], params.coeffs) ){
+                cout << "Error: --coeffs needs eight comma-separated numbers.\n";
+                return(1);
+            }
+        } else if( (strcmp(argv[i], "--seed") == 0) && (i + 1 < argc) ){
+            params.seed = strtoull(argv[++i], NULL, 10);
+        } else if( (strcmp(argv[i], "--dir") == 0) && (i + 1 < argc) ){
+            outputDir = argv[++i];
+        } else {
+            cout << "Error: unrecognized option " << argv[i] << ".\n";
+            cout << "Usage: generate_synthetic_data.exe [--bids N] [--bidder-types N] [--obs-types N]"
+                 << " [--unobs-types N] [--max-auction-size N] [--num-samples N] [--coeffs c1,...,c8]"
+                 << " [--seed S] [--dir DIR]\n";
+            return(1);
+        }
+    }
+    if( (params.numBids <= 0) | (params.aucTraits.numBidderTypes <= 0) | (params.aucTraits.numObsAucTypes <= 0) |
+        (params.aucTraits.numUnobsAucTypes <= 0) | (params.numSamples <= 0) ){
+        cout << "Error: the numbers of bids, types, and samples must be positive.\n";
+        return(1);
+    }
+    if( params.maxAuctionSize < 2 ){
+        cout << "Error: --max-auction-size must be at least 2.\n";
+        return(1);
+    }
+    if( params.coeffs.nestCorr <= 0 ){
+        cout << "Error: the nesting parameter (c8) must be positive.\n";
+        return(1);
+    }
+
+    // Write the files in their own directory, so that real data is never overwritten by accident
+    mkdir(outputDir, 0755);
+    if( chdir(outputDir) != 0 ){
+        cout << "Error: could not enter " << outputDir << ".\n";
+        return(1);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t bytesWritten;
+    if( !writeSyntheticData(params, bytesWritten) ){
+        return(1);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Wrote " << params.numBids << " bids and " << params.numSamples << " sample bids in each of "
+         << params.aucTraits.numBidderTypes*params.aucTraits.numObsAucTypes*params.aucTraits.numUnobsAucTypes
+         << " type cells to " << outputDir << " (" << bytesWritten / 1e6 << " MB in " << seconds << " s)\n";
+
+    return 0;
+}
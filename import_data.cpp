@@ -0,0 +1,428 @@
+// import_data.cpp
+// Functions to import the sample bids and auction distributions written by the earlier stages of
+// the estimation.  Shared by calculate_costs.cpp and debug_bid_selection.cpp.
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "import_data.hpp"
+#include "checkpoint.hpp" // For hashBytes(), the checksums of the manifest
+#include <dirent.h> // For opendir(), to list the sample bid files
+#include <sys/stat.h> // For stat(), to check file sizes against the manifest
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+//// Functions to find and check the sample bid files
+
+// Name of the sample bid file of a type cell (types indexed from 0)
+static string sampleBidFileName(int bidderType, int obsAucType, int uAucType){
+    char fileName[100];
+    sprintf(fileName, "sample_bids_btype_%d_oauctype_%d_uauctype_%d.csv", bidderType + 1, obsAucType + 1,
+            uAucType + 1);
+    return( string(fileName) );
+}
+
+// Read a whole file into contents.  Returns false (with the reason in error) if it can't be read.
+static bool readWholeFile(const string& fileName, vector<char>& contents, string& error){
+    FILE *inFile = fopen(fileName.c_str(), "rb");
+    if( inFile == NULL ){
+        error = "could not open " + fileName;
+        return( false );
+    }
+    fseek(inFile, 0, SEEK_END);
+    long numBytes = ftell(inFile);
+    fseek(inFile, 0, SEEK_SET);
+    contents.resize(max(numBytes, 0L));
+    bool failed = (numBytes < 0) || (fread(contents.data(), 1, contents.size(), inFile) != contents.size());
+    fclose(inFile);
+    if( failed ){
+        error = "could not read " + fileName;
+        return( false );
+    }
+    return( true );
+}
+
+// Run task(cell, error) for every type cell, numThreads cells at a time.  Each thread takes the
+// next cell from a shared counter.  Errors are printed in cell order once every cell is done, so
+// all problems are reported together and the output doesn't depend on the number of threads.
+// Returns false if any task did.
+template <typename Task>
+static bool runOnCells(int numCells, int numThreads, const Task& task){
+
+    vector<string> errors(numCells);
+    atomic<int> nextCell(0);
+    auto worker = [&](){
+        for(int cell = nextCell.fetch_add(1); cell < numCells; cell = nextCell.fetch_add(1)){
+            task(cell, errors[cell]);
+        }
+    };
+    vector<thread> threads;
+    for(int t = 1; t < min(numThreads, numCells); t++){
+        threads.push_back( thread(worker) );
+    }
+    worker();
+    for(size_t t = 0; t < threads.size(); t++){
+        threads[t].join();
+    }
+
+    bool failed = false;
+    for(int cell = 0; cell < numCells; cell++){
+        if( !errors[cell].empty() ){
+            cout << "Error: " << errors[cell] << ".\n";
+            failed = true;
+        }
+    }
+    return( !failed );
+}
+
+
+// Find the number of bidder and auction types by listing the working directory once.  (Probing
+// for files by name took one open per guess and only looked along the first index of each axis,
+// so a missing file silently cut the number of types short.)
+bool findSampleBidTypes(AucTraits& aucTraits){
+
+    DIR *directory = opendir(".");
+    if( directory == NULL ){
+        cout << "Error: could not list the working directory.\n";
+        return( false );
+    }
+
+    // Type indices (from 1) of every sample bid file, and the largest on each axis
+    vector<int> foundTypes;
+    int maxTypes[3] = {0, 0, 0};
+    for(struct dirent *entry = readdir(directory); entry != NULL; entry = readdir(directory)){
+        int types[3];
+        int nameLength = 0;
+        sscanf(entry->d_name, "sample_bids_btype_%d_oauctype_%d_uauctype_%d.csv%n", &types[0], &types[1],
+               &types[2], &nameLength);
+        if( (nameLength == 0) || (entry->d_name[nameLength] != '\0') ){
+            continue;
+        }
+        if( (types[0] < 1) || (types[1] < 1) || (types[2] < 1) ){
+            cout << "Error: " << entry->d_name << " has a type below 1.\n";
+            closedir(directory);
+            return( false );
+        }
+        for(int axis = 0; axis < 3; axis++){
+            foundTypes.push_back(types[axis]);
+            maxTypes[axis] = max(maxTypes[axis], types[axis]);
+        }
+    }
+    closedir(directory);
+
+    aucTraits.numBidderTypes = maxTypes[0];
+    aucTraits.numObsAucTypes = maxTypes[1];
+    aucTraits.numUnobsAucTypes = maxTypes[2];
+    if( foundTypes.empty() ){
+        cout << "Error: no sample_bids_* files in the working directory.\n";
+        return( false );
+    }
+
+    // Every cell of the grid needs a file
+    vector<char> found((size_t)maxTypes[0]*maxTypes[1]*maxTypes[2], 0);
+    for(size_t f = 0; f < foundTypes.size(); f += 3){
+        found[((size_t)(foundTypes[f] - 1)*maxTypes[1] + foundTypes[f + 1] - 1)*maxTypes[2] + foundTypes[f + 2] - 1] = 1;
+    }
+    bool complete = true;
+    for(int i = 0; i < maxTypes[0]; i++){
+        for(int j = 0; j < maxTypes[1]; j++){
+            for(int k = 0; k < maxTypes[2]; k++){
+                if( !found[((size_t)i*maxTypes[1] + j)*maxTypes[2] + k] ){
+                    cout << "Error: " << sampleBidFileName(i, j, k) << " is missing.\n";
+                    complete = false;
+                }
+            }
+        }
+    }
+    return( complete );
+}
+
+
+// Write the manifest of the standard sample bid files of every type cell
+bool writeSampleBidManifest(const char *fileName, AucTraits aucTraits, int numThreads){
+
+    // Size and checksum of every file, read in parallel
+    int numCells = aucTraits.numBidderTypes*aucTraits.numObsAucTypes*aucTraits.numUnobsAucTypes;
+    vector<SampleBidFile> files(numCells);
+    bool readAll = runOnCells(numCells, numThreads, [&](int cell, string& error){
+        int k = cell % aucTraits.numUnobsAucTypes;
+        int j = (cell / aucTraits.numUnobsAucTypes) % aucTraits.numObsAucTypes;
+        int i = cell / (aucTraits.numUnobsAucTypes*aucTraits.numObsAucTypes);
+        files[cell].fileName = sampleBidFileName(i, j, k);
+        vector<char> contents;
+        if( readWholeFile(files[cell].fileName, contents, error) ){
+            files[cell].bytes = contents.size();
+            files[cell].checksum = hashBytes(contents.data(), contents.size(), fnvOffsetBasis);
+        }
+    });
+    if( !readAll ){
+        return( false );
+    }
+
+    FILE *outFile = fopen(fileName, "w");
+    if( outFile == NULL ){
+        cout << "Error: could not write " << fileName << ".\n";
+        return( false );
+    }
+    fprintf(outFile, "# Sample bid files of every type cell (see import_data.hpp)\n");
+    fprintf(outFile, "bidder_types %d\n", aucTraits.numBidderTypes);
+    fprintf(outFile, "obs_auc_types %d\n", aucTraits.numObsAucTypes);
+    fprintf(outFile, "unobs_auc_types %d\n", aucTraits.numUnobsAucTypes);
+    fprintf(outFile, "# bidder_type obs_auc_type unobs_auc_type bytes checksum file\n");
+    for(int cell = 0; cell < numCells; cell++){
+        int k = cell % aucTraits.numUnobsAucTypes;
+        int j = (cell / aucTraits.numUnobsAucTypes) % aucTraits.numObsAucTypes;
+        int i = cell / (aucTraits.numUnobsAucTypes*aucTraits.numObsAucTypes);
+        fprintf(outFile, "%d %d %d %lld %016llx %s\n", i + 1, j + 1, k + 1, files[cell].bytes,
+                (unsigned long long)files[cell].checksum, files[cell].fileName.c_str());
+    }
+    bool failed = (ferror(outFile) != 0);
+    failed |= (fclose(outFile) != 0);
+    if( failed ){
+        cout << "Error: could not finish writing " << fileName << ".\n";
+    }
+    return( !failed );
+}
+
+
+// Read a manifest, checking that it lists every type cell exactly once
+bool readSampleBidManifest(const char *fileName, SampleBidManifest& manifest){
+
+    FILE *inFile = fopen(fileName, "r");
+    if( inFile == NULL ){
+        cout << "Error: could not open " << fileName << "; write it with convert_sample_bids.exe --write-manifest.\n";
+        return( false );
+    }
+
+    // The three type counts come first, then one line per file; blank lines and comments are skipped
+    int typeCounts[3] = {0, 0, 0};
+    const char *countNames[3] = {"bidder_types", "obs_auc_types", "unobs_auc_types"};
+    int numCounts = 0;
+    vector<int> listed;
+    char line[1000];
+    int lineNumber = 0;
+    bool valid = true;
+    while( valid && (fgets(line, sizeof(line), inFile) != NULL) ){
+        lineNumber++;
+        if( (line[0] == '#') || (line[strspn(line, " \t\r\n")] == '\0') ){
+            continue;
+        }
+        if( numCounts < 3 ){
+            char name[100];
+            valid = (sscanf(line, "%99s %d", name, &typeCounts[numCounts]) == 2) &&
+                (strcmp(name, countNames[numCounts]) == 0) && (typeCounts[numCounts] > 0);
+            numCounts++;
+            if( numCounts == 3 ){
+                manifest.aucTraits.numBidderTypes = typeCounts[0];
+                manifest.aucTraits.numObsAucTypes = typeCounts[1];
+                manifest.aucTraits.numUnobsAucTypes = typeCounts[2];
+                manifest.files.assign((size_t)typeCounts[0]*typeCounts[1]*typeCounts[2], SampleBidFile());
+                listed.assign(manifest.files.size(), 0);
+            }
+            continue;
+        }
+        int i, j, k;
+        long long bytes;
+        unsigned long long checksum;
+        char cellFile[1000];
+        valid = (sscanf(line, "%d %d %d %lld %llx %999s", &i, &j, &k, &bytes, &checksum, cellFile) == 6) &&
+            (i >= 1) && (i <= typeCounts[0]) && (j >= 1) && (j <= typeCounts[1]) && (k >= 1) && (k <= typeCounts[2]);
+        if( !valid ){
+            break;
+        }
+        int cell = ((i - 1)*typeCounts[1] + j - 1)*typeCounts[2] + k - 1;
+        if( listed[cell] ){
+            cout << "Error: line " << lineNumber << " of " << fileName << " lists a type cell a second time.\n";
+            fclose(inFile);
+            return( false );
+        }
+        listed[cell] = 1;
+        manifest.files[cell].fileName = cellFile;
+        manifest.files[cell].bytes = bytes;
+        manifest.files[cell].checksum = checksum;
+    }
+    fclose(inFile);
+    if( !valid ){
+        cout << "Error: line " << lineNumber << " of " << fileName << " is malformed.\n";
+        return( false );
+    }
+    if( numCounts < 3 ){
+        cout << "Error: " << fileName << " doesn't give the number of every kind of type.\n";
+        return( false );
+    }
+
+    // Completeness: every cell needs a file
+    bool complete = true;
+    for(size_t cell = 0; cell < listed.size(); cell++){
+        if( !listed[cell] ){
+            int k = cell % typeCounts[2];
+            int j = (cell / typeCounts[2]) % typeCounts[1];
+            int i = cell / (typeCounts[2]*typeCounts[1]);
+            cout << "Error: " << fileName << " lists no file for bidder type " << i + 1 << ", observed auction type "
+                 << j + 1 << ", unobserved auction type " << k + 1 << ".\n";
+            complete = false;
+        }
+    }
+    return( complete );
+}
+
+
+//// Functions to import data
+
+// Import sample bids
+// Helper function to parse one line of a sample bid file into a bid
+Bid getSampleBid(const char *line){
+
+    // Declare bid object to return and fill with the current line
+    Bid currentBid;
+
+    // Only the amount and bidder type vary across sample bids; auction-specific fields are filled
+    // in from the focal bid in simulateAuctions()
+    sscanf(line, "%lf, %d", &currentBid.amount, &currentBid.bidderType);
+    
+    return( currentBid );
+}
+// Fill in the sample bid store from the file of each (bidder type, observed auction type,
+// unobserved auction type) cell in the manifest.  Each file must have at least
+// sampleBids.numSamples() rows after its header.
+bool importSampleBids(SampleBidStore& sampleBids, const SampleBidManifest& manifest, int numThreads){
+
+    // Check every file's size before parsing any, so that a missing or replaced file stops the run
+    // at once instead of after the files before it have been read
+    int numCells = manifest.files.size();
+    bool allPresent = runOnCells(numCells, numThreads, [&](int cell, string& error){
+        const SampleBidFile& file = manifest.files[cell];
+        struct stat fileStatus;
+        if( stat(file.fileName.c_str(), &fileStatus) != 0 ){
+            error = file.fileName + " is missing";
+        } else if( (long long)fileStatus.st_size != file.bytes ){
+            error = file.fileName + " has " + to_string((long long)fileStatus.st_size) + " bytes; the manifest lists " +
+                to_string(file.bytes);
+        }
+    });
+    if( !allPresent ){
+        return( false );
+    }
+
+    // Read each file whole, check its checksum, and parse its rows into its cell
+    bool imported = runOnCells(numCells, numThreads, [&](int cell, string& error){
+        const SampleBidFile& file = manifest.files[cell];
+        vector<char> contents;
+        if( !readWholeFile(file.fileName, contents, error) ){
+            return;
+        }
+        if( hashBytes(contents.data(), contents.size(), fnvOffsetBasis) != file.checksum ){
+            error = file.fileName + " doesn't match its checksum in the manifest";
+            return;
+        }
+
+        // Skip the header line, then parse one row per line.  Each line is copied out first, since
+        // sscanf() on the whole buffer would scan to its end on every call.
+        const char *next = (const char*)memchr(contents.data(), '\n', contents.size());
+        const char *end = contents.data() + contents.size();
+        char line[10000];
+        for(int row = 0; row < sampleBids.numSamples(); row++){
+            if( (next == NULL) || (next + 1 >= end) ){
+                error = file.fileName + " has " + to_string(row) + " sample bids; expected " +
+                    to_string(sampleBids.numSamples());
+                return;
+            }
+            const char *lineStart = next + 1;
+            next = (const char*)memchr(lineStart, '\n', end - lineStart);
+            size_t lineLength = min((size_t)((next != NULL ? next : end) - lineStart), sizeof(line) - 1);
+            memcpy(line, lineStart, lineLength);
+            line[lineLength] = '\0';
+            sampleBids.setBid(cell, row, getSampleBid(line));
+        }
+    });
+    if( imported ){
+        int threadsUsed = max(1, min(numThreads, numCells));
+        cout << "Imported " << numCells << " sample bid files on " << threadsUsed << (threadsUsed == 1 ? " thread\n" : " threads\n");
+    }
+    return( imported );
+}
+
+// Import the distribution of bidder types in each observed type of auction
+// Returns one alias table per observed auction type, drawing a bidder type indexed from 0
+vector<AliasTable> importBidderTypeDist(AucTraits aucTraits){
+
+    // Open the file and look for aucTraits.numObsAucTypes rows
+    ifstream infile("bidder_type_distribution.csv");
+
+    // Declare the output array
+    vector<double> emptyVec;
+    vector< vector<double> > bidderTypeDist(aucTraits.numObsAucTypes, emptyVec);
+
+
+    // Read each cell into the string readProb
+    string readProb;
+    // Traverse rows and columns
+    for(int row = 0; row < aucTraits.numObsAucTypes; row++){
+        for(int col = 0; col < aucTraits.numBidderTypes; col++){
+
+            // Take up to the next delimiter (comma unless it's the last column)
+            if( col < aucTraits.numBidderTypes - 1 ){
+                getline(infile, readProb, ',');
+            } else {
+                getline(infile, readProb, '\n');
+            }
+
+            // Define the probability of each bin
+            bidderTypeDist[row].push_back( atof(readProb.c_str()) );
+        }
+    }
+
+    // Return alias tables, which turn each draw into a single table lookup
+    vector<AliasTable> bidderTypeTables;
+    for(int row = 0; row < aucTraits.numObsAucTypes; row++){
+        bidderTypeTables.push_back( AliasTable(bidderTypeDist[row]) );
+    }
+    return( bidderTypeTables );
+}
+
+
+// Import the distribution of the number of bids in each observed type of auction
+// Returns one alias table per observed auction type, drawing the number of other bids minus one
+vector<AliasTable> importNumBidDist(AucTraits aucTraits){
+
+    // Open the file and look for aucTraits.numObsAucTypes rows
+    ifstream infile("num_bid_distribution.csv");
+
+    // Get the number of columns in the file
+    string firstLine;
+    getline(infile, firstLine);
+    int numCols = count(firstLine.begin(), firstLine.end(), ',') + 1;
+    // Reset to the start of the file
+    infile.seekg(0, ios::beg);
+    
+    // Declare the output array
+    vector<double> emptyVec;
+    vector< vector<double> > numBidDist(aucTraits.numObsAucTypes, emptyVec);
+
+
+    // Read each cell into the string readProb
+    string readProb;
+    // Traverse rows and columns
+    for(int row = 0; row < aucTraits.numObsAucTypes; row++){
+        for(int col = 0; col < numCols; col++){
+
+            // Take up to the next delimiter (comma unless it's the last column)
+            if( col < numCols - 1 ){
+                getline(infile, readProb, ',');
+            } else {
+                getline(infile, readProb, '\n');
+            }
+
+            // Define the probability of each bin
+            numBidDist[row].push_back( atof(readProb.c_str()) );
+        }
+    }
+    
+    // Return alias tables, which turn each draw into a single table lookup
+    vector<AliasTable> numBidTables;
+    for(int row = 0; row < aucTraits.numObsAucTypes; row++){
+        numBidTables.push_back( AliasTable(numBidDist[row]) );
+    }
+    return( numBidTables );
+}
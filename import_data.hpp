@@ -0,0 +1,71 @@
+// import_data.hpp
+// Declarations for the functions importing the sample bids and auction distributions used by
+// calculate_costs.cpp and debug_bid_selection.cpp
+// The sample bid files are listed in a manifest (sample_bids_manifest.txt) giving the number of
+// bidder and auction types and, for every type cell, its file, size, and checksum:
+//   # comment lines start with #
+//   bidder_types 3
+//   obs_auc_types 2
+//   unobs_auc_types 2
+//   # bidder_type obs_auc_type unobs_auc_type bytes checksum file
+//   1 1 1 245761 9f3c1d22a0b47e55 sample_bids_btype_1_oauctype_1_uauctype_1.csv
+//   ...
+// Types are indexed from 1 and the checksum is the 64-bit FNV-1a hash of the file in hex.
+// convert_sample_bids.exe --write-manifest writes it from the files in the working directory.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef IMPORT_DATA_INCLUDED
+#define IMPORT_DATA_INCLUDED
+
+#include <stdint.h>
+#include <string>
+#include "bid_selection.hpp"
+#include "alias_table.hpp"
+#include "sample_bid_store.hpp"
+
+
+// Default name of the sample bid manifest
+const char *const sampleBidManifestFile = "sample_bids_manifest.txt";
+
+// One sample bid file listed in the manifest
+typedef struct {
+    std::string fileName;
+    long long bytes;
+    uint64_t checksum; // 64-bit FNV-1a hash of the whole file
+} SampleBidFile;
+
+// Contents of a manifest: the number of types, and the file of each type cell in the order of
+// SampleBidStore::cellIndex()
+typedef struct {
+    AucTraits aucTraits;
+    std::vector<SampleBidFile> files;
+} SampleBidManifest;
+
+// Function to find the number of bidder and auction types from the sample_bids_btype_*_oauctype_*_
+// uauctype_*.csv files in the working directory.  Every type cell up to the largest index on each
+// axis must have a file; returns false (after listing the missing cells) if any doesn't.
+bool findSampleBidTypes(AucTraits& aucTraits);
+// Function to write a manifest of the sample bid files of every type cell, reading numThreads
+// files at a time to find their sizes and checksums.  Returns false (after printing an error) if a
+// file can't be read or the manifest can't be written.
+bool writeSampleBidManifest(const char *fileName, AucTraits aucTraits, int numThreads);
+// Function to read a manifest.  Returns false (after printing an error) if it can't be read, is
+// malformed, or doesn't list exactly one file for every type cell.
+bool readSampleBidManifest(const char *fileName, SampleBidManifest& manifest);
+
+// Function to parse one line of a sample bid file
+Bid getSampleBid(const char *line);
+// Function to import the sample bids of every file in the manifest into the store, numThreads
+// files at a time.  Every file's size is checked against the manifest before any is parsed, and
+// its checksum as it is read.  Returns false (after listing every file that is missing, changed,
+// or short) on any failure.
+bool importSampleBids(SampleBidStore& sampleBids, const SampleBidManifest& manifest, int numThreads);
+
+// Function to import distribution of bidder types (one alias table per observed auction type)
+std::vector<AliasTable> importBidderTypeDist(AucTraits aucTraits);
+// Function to import distribution of number of bidders (one alias table per observed auction type)
+std::vector<AliasTable> importNumBidDist(AucTraits aucTraits);
+
+
+// End header guard with endif statement
+#endif
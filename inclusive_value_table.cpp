@@ -0,0 +1,48 @@
+// inclusive_value_table.cpp
+// Building the inclusive value tables declared in inclusive_value_table.hpp
+
+#include "inclusive_value_table.hpp"
+
+
+using namespace std;
+
+
+// Stream type for the simulations behind the tables, distinct from the streams of individual
+// bids and of draws shared across bids
+static const uint32_t tableDrawStream = 0xFFFFFFFE;
+
+
+InclusiveValueTable::InclusiveValueTable(AucTraits aucTraits, uint64_t seed, int numDraws, int numQuantiles,
+                                         const vector<AliasTable>& numBidDist,
+                                         const vector<AliasTable>& bidderTypeDist,
+                                         const SampleBidStore& sampleBids,
+                                         const BidSelectionParams& bidSelParams){
+
+    // More quantiles than draws would only repeat draws
+    numQuantiles = min(numQuantiles, numDraws);
+    this->numUnobsAucTypes = aucTraits.numUnobsAucTypes;
+    this->numQuantiles = numQuantiles;
+    quantiles.resize((size_t)aucTraits.numObsAucTypes * aucTraits.numUnobsAucTypes * numQuantiles);
+
+    CompetitorDraws draws;
+    vector<double> logExpSums(numDraws);
+    for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+
+        draws.draw(seed, j, tableDrawStream, 0, numDraws, numBidDist[j], bidderTypeDist[j], sampleBids.numSamples());
+
+        for(int k = 0; k < aucTraits.numUnobsAucTypes; k++){
+
+            // Inclusive value of every simulated auction, sorted
+            for(int sim = 0; sim < numDraws; sim++){
+                logExpSums[sim] = competitorLogExpSum(draws, sim, j, k, sampleBids, bidSelParams);
+            }
+            sort(logExpSums.begin(), logExpSums.end());
+
+            // Quantile q is the draw at the middle of the q-th of numQuantiles equal slices
+            double *cellQuantiles = quantiles.data() + (size_t)(j*numUnobsAucTypes + k)*numQuantiles;
+            for(int q = 0; q < numQuantiles; q++){
+                cellQuantiles[q] = logExpSums[ (size_t)((q + 0.5) * numDraws / numQuantiles) ];
+            }
+        }
+    }
+}
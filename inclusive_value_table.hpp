@@ -0,0 +1,51 @@
+// inclusive_value_table.hpp
+// Tables of competitor inclusive values for each (observed auction type, unobserved auction type)
+// cell.  In the nested logit, the competitors of an auction enter the focal bid's selection
+// probability only through their inclusive value, the log of the sum of exp(utility / nestCorr)
+// over the other bids, and its distribution doesn't depend on the focal bid.  The table simulates
+// that distribution once per cell and keeps a fixed number of its quantiles, so that each bid is
+// evaluated against the quantiles (O(table size)) instead of against freshly simulated competitors
+// (O(simulations x competitors)).
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef INCLUSIVE_VALUE_TABLE_INCLUDED
+#define INCLUSIVE_VALUE_TABLE_INCLUDED
+
+#include "bid_selection.hpp"
+#include "sample_bid_store.hpp"
+
+
+class InclusiveValueTable {
+
+public:
+
+    // Simulate numDraws auctions for every observed auction type (drawing from the streams keyed by
+    // (seed, observed auction type, tableDrawStream, simulation)) and keep numQuantiles quantiles of
+    // the inclusive value in each unobserved auction type.  The unobserved types of an observed type
+    // share their simulated competitors, as with common draws.
+    InclusiveValueTable(AucTraits aucTraits, uint64_t seed, int numDraws, int numQuantiles,
+                        const std::vector<AliasTable>& numBidDist,
+                        const std::vector<AliasTable>& bidderTypeDist,
+                        const SampleBidStore& sampleBids,
+                        const BidSelectionParams& bidSelParams);
+
+    // Quantiles of the inclusive value in a cell (auction types indexed from 0), in increasing order;
+    // each stands for an equal share of the simulated auctions
+    const double *values(int obsAucType, int uAucType) const {
+        return( quantiles.data() + (size_t)(obsAucType*numUnobsAucTypes + uAucType)*numQuantiles );
+    }
+    // Number of quantiles in each cell
+    int size() const {
+        return( numQuantiles );
+    }
+
+private:
+
+    int numUnobsAucTypes;
+    int numQuantiles;
+    std::vector<double> quantiles;
+};
+
+
+// End header guard with endif statement
+#endif
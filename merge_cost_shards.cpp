@@ -0,0 +1,127 @@
+// merge_cost_shards.cpp
+// Stitch the outputs of calculate_costs.exe --shard 1/N, ..., N/N back into the estimated_costs.csv
+// a single run would have written.  The shards are checked before anything is written: all N must
+// be present, come from the same run (seed and fingerprint), and cover every row exactly once, in
+// order, with one line per row.
+// Compiled as: g++ -O2 -o merge_cost_shards.exe merge_cost_shards.cpp cost_shards.cpp
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "cost_shards.hpp"
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+// Check the header of shard index of numShards against the run and the rows merged so far
+// (nextRow), printing an error if it doesn't fit.  The first shard sets the run.
+bool checkShardHeader(const string& fileName, const ShardHeader& header, int index, int numShards,
+                      long long nextRow, ShardHeader& run){
+
+    if( (header.index != index) || (header.numShards != numShards) ){
+        cout << "Error: " << fileName << " says it is shard " << header.index << "/" << header.numShards << ".\n";
+        return( false );
+    }
+    if( index == 1 ){
+        run = header;
+    } else if( (header.totalRows != run.totalRows) || (header.seed != run.seed) ||
+               (header.fingerprint != run.fingerprint) ){
+        cout << "Error: " << fileName << " comes from a different run than shard 1 (its row count, seed, or "
+             << "fingerprint differs).\n";
+        return( false );
+    }
+    if( (header.firstRow != nextRow) || (header.endRow < header.firstRow) || (header.endRow > header.totalRows) ){
+        cout << "Error: " << fileName << " covers rows " << header.firstRow << "-" << header.endRow
+             << "; expected rows from " << nextRow << " on.\n";
+        return( false );
+    }
+    return( true );
+}
+
+
+// Command line options:
+//   --shards N        number of shards, read from estimated_costs.shard_i_of_N.csv (required)
+//   --output FILE     merged file (default estimated_costs.csv)
+int main(int argc, char *argv[]){
+
+    // Read command line options
+    int numShards = 0;
+    const char *outputFile = "estimated_costs.csv";
+    for(int i = 1; i < argc; i++){
+        if( (strcmp(argv[i], "--shards") == 0) && (i + 1 < argc) ){
+            numShards = atoi(argv[++i]);
+        } else if( (strcmp(argv[i], "--output") == 0) && (i + 1 < argc) ){
+            outputFile = argv[++i];
+        } else {
+            cout << "Error: unrecognized option " << argv[i] << ".\n";
+            cout << "Usage: merge_cost_shards.exe --shards N [--output FILE]\n";
+            return(1);
+        }
+    }
+    if( numShards <= 0 ){
+        cout << "Error: --shards must be positive.\n";
+        return(1);
+    }
+
+    // Copy the shards' lines to a temporary file, renamed over the output only once every shard has
+    // checked out, so that a failed merge never leaves a partial estimated_costs.csv
+    string tempFile = string(outputFile) + ".tmp";
+    ofstream merged(tempFile.c_str());
+    if( !merged.good() ){
+        cout << "Error: could not write " << tempFile << ".\n";
+        return(1);
+    }
+    ShardHeader run;
+    long long nextRow = 0;
+    bool valid = true;
+    string line;
+    for(int index = 1; valid && (index <= numShards); index++){
+
+        string fileName = shardFileName("estimated_costs", "csv", index, numShards);
+        ifstream shardFile(fileName.c_str());
+        ShardHeader header;
+        if( !shardFile.good() ){
+            cout << "Error: " << fileName << " is missing.\n";
+            valid = false;
+        } else if( !getline(shardFile, line) || !parseShardHeader(line.c_str(), header) ){
+            cout << "Error: " << fileName << " doesn't start with a shard header.\n";
+            valid = false;
+        } else {
+            valid = checkShardHeader(fileName, header, index, numShards, nextRow, run);
+        }
+        if( !valid ){
+            break;
+        }
+
+        long long numLines = 0;
+        while( getline(shardFile, line) ){
+            merged << line << "\n";
+            numLines++;
+        }
+        if( numLines != header.endRow - header.firstRow ){
+            cout << "Error: " << fileName << " has " << numLines << " lines for " << header.endRow - header.firstRow
+                 << " rows.\n";
+            valid = false;
+        }
+        nextRow = header.endRow;
+    }
+    if( valid && (nextRow != run.totalRows) ){
+        cout << "Error: the shards end at row " << nextRow << " of " << run.totalRows << ".\n";
+        valid = false;
+    }
+    merged.close();
+    if( valid && merged.fail() ){
+        cout << "Error: could not finish writing " << tempFile << ".\n";
+        valid = false;
+    }
+    if( !valid || (rename(tempFile.c_str(), outputFile) != 0) ){
+        if( valid ){
+            cout << "Error: could not write " << outputFile << ".\n";
+        }
+        remove(tempFile.c_str());
+        return(1);
+    }
+
+    cout << "Merged " << numShards << " shards of " << run.totalRows << " rows into " << outputFile << "\n";
+    return 0;
+}
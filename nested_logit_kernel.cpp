@@ -0,0 +1,135 @@
+// nested_logit_kernel.cpp
+// Scalar and vectorized nested logit kernels declared in nested_logit_kernel.hpp, and the runtime
+// choice between them
+
+#include "nested_logit_kernel.hpp"
+
+
+using namespace std;
+
+
+//// Scalar kernel: the fallback for CPUs without AVX2, using the same max-shifted formulas as the
+//// vector kernels but with libm's exp and log.  Each simulation loops over its own competitors, so
+//// the block's largest number of competitors (which the vector kernels pad to) goes unused.
+
+template<bool isNested>
+static void scalarKernel(const double *utilities, const int *numOtherBids, int numSims,
+                         int /* maxOtherBids */, const FocalBidTerms& focal, SimulationSums& sums){
+
+    for(int lane = 0; lane < numSims; lane++){
+
+        // Max-shifted log-sum-exp of all utilities in the nest
+        double maxUtil = focal.focalUtil;
+        for(int i = 0; i < numOtherBids[lane]; i++){
+            maxUtil = max(maxUtil, utilities[i*simBlockSize + lane]);
+        }
+        double focalTerm = exp(focal.focalUtil - maxUtil);
+        double expSum = focalTerm;
+        for(int i = 0; i < numOtherBids[lane]; i++){
+            expSum += exp(utilities[i*simBlockSize + lane] - maxUtil);
+        }
+        double incVal = maxUtil + log(expSum);
+
+        // Share of the focal bid within the nest and probability of choosing the nest
+        double share = focalTerm / expSum;
+        double nestProb = 1 / (1 + exp(-(focal.nestUtil + (isNested ? focal.nestCorr*incVal : incVal))));
+
+        // Selection probability and its derivative with respect to the bid amount
+        double prob = nestProb*share;
+        double probDer = isNested ? prob*focal.amountCoeff*(share*(1 - nestProb) + focal.invNestCorr*(1 - share))
+                                  : prob*focal.amountCoeff*(1 - prob);
+        sums.probSum += prob;
+        sums.probDerSum += probDer;
+        sums.probSqSum += prob*prob;
+        sums.probDerSqSum += probDer*probDer;
+        sums.probCrossSum += prob*probDer;
+    }
+}
+
+
+//// Vector kernels: the same source compiled for each instruction set (x86-64 only)
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define KERNEL_NAMESPACE avx2Kernel
+#define KERNEL_LANES 4
+#include "nested_logit_kernel.inc"
+#undef KERNEL_NAMESPACE
+#undef KERNEL_LANES
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define KERNEL_NAMESPACE avx512Kernel
+#define KERNEL_LANES 8
+#include "nested_logit_kernel.inc"
+#undef KERNEL_NAMESPACE
+#undef KERNEL_LANES
+#pragma GCC pop_options
+
+#define HAVE_VECTOR_KERNELS
+#endif
+
+
+//// Runtime dispatch
+
+// The kernels in use for the nested and multinomial logit, and the instruction set's name (NULL
+// until the first call to setNestedLogitKernel())
+static NestedLogitKernel currentKernel = NULL;
+static NestedLogitKernel currentLogitKernel = NULL;
+static const char *currentKernelName = NULL;
+
+// Choose a kernel by name, checking that the CPU supports it
+bool setNestedLogitKernel(const char *name){
+
+    bool isAuto = (strcmp(name, "auto") == 0);
+
+#ifdef HAVE_VECTOR_KERNELS
+    __builtin_cpu_init();
+    if( (isAuto || strcmp(name, "avx512") == 0) && __builtin_cpu_supports("avx512f") ){
+        currentKernel = avx512Kernel::kernel<true>;
+        currentLogitKernel = avx512Kernel::kernel<false>;
+        currentKernelName = "avx512";
+        return( true );
+    }
+    if( (isAuto || strcmp(name, "avx2") == 0) && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ){
+        currentKernel = avx2Kernel::kernel<true>;
+        currentLogitKernel = avx2Kernel::kernel<false>;
+        currentKernelName = "avx2";
+        return( true );
+    }
+#endif
+
+    if( isAuto || strcmp(name, "scalar") == 0 ){
+        currentKernel = scalarKernel<true>;
+        currentLogitKernel = scalarKernel<false>;
+        currentKernelName = "scalar";
+        return( true );
+    }
+    return( false );
+}
+
+const char *nestedLogitKernelName(){
+    if( currentKernel == NULL ){
+        setNestedLogitKernel("auto");
+    }
+    return( currentKernelName );
+}
+
+void evaluateNestedLogit(const double *utilities, const int *numOtherBids, int numSims,
+                         int maxOtherBids, const FocalBidTerms& focal, SimulationSums& sums){
+    if( currentKernel == NULL ){
+        setNestedLogitKernel("auto");
+    }
+    currentKernel(utilities, numOtherBids, numSims, maxOtherBids, focal, sums);
+}
+
+void evaluateMultinomialLogit(const double *utilities, const int *numOtherBids, int numSims,
+                              int maxOtherBids, const FocalBidTerms& focal, SimulationSums& sums){
+    if( currentLogitKernel == NULL ){
+        setNestedLogitKernel("auto");
+    }
+    currentLogitKernel(utilities, numOtherBids, numSims, maxOtherBids, focal, sums);
+}
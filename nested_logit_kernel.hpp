@@ -0,0 +1,49 @@
+// nested_logit_kernel.hpp
+// Vectorized evaluation of the nested logit selection probability and its derivative for blocks of
+// simulated auctions.  simulateAuctions() draws the competitors of up to simBlockSize auctions,
+// lays their utilities out so that each auction occupies one SIMD lane, and hands the block to the
+// kernel.  The kernel is chosen at runtime from the instruction sets the CPU supports.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef NESTED_LOGIT_KERNEL_INCLUDED
+#define NESTED_LOGIT_KERNEL_INCLUDED
+
+#include "bid_selection.hpp"
+
+
+// The number of simulated auctions evaluated together, simBlockSize, is defined in bid_selection.hpp
+
+// Terms of the nested logit that depend only on the focal bid, not on its competitors
+typedef struct {
+    double focalUtil;   // utility of the focal bid, already divided by nestCorr
+    double nestUtil;    // utility of choosing a bid rather than the outside option
+    double nestCorr;    // nesting parameter
+    double invNestCorr; // 1 / nestCorr
+    double amountCoeff; // coefficient on the bid amount (not divided by nestCorr)
+} FocalBidTerms;
+
+// Signature shared by the kernels
+// utilities[i*simBlockSize + lane] is the utility of competitor i in auction lane; entries with
+// i >= numOtherBids[lane] (up to maxOtherBids) are ignored.  Adds the probabilities and
+// derivatives of the first numSims lanes, and their squares and products, to sums.
+typedef void (*NestedLogitKernel)(const double *utilities, const int *numOtherBids, int numSims,
+                                  int maxOtherBids, const FocalBidTerms& focal, SimulationSums& sums);
+
+// Choose the kernel: "auto" (the widest one the CPU supports), "scalar", "avx2", or "avx512".
+// Returns false, leaving the current choice in place, if the name is unknown or the CPU lacks the
+// instructions.  Call before starting any threads; without a call the kernel is chosen as "auto".
+bool setNestedLogitKernel(const char *name);
+// Name of the kernel in use
+const char *nestedLogitKernelName();
+
+// Evaluate a block of simulated auctions with the chosen kernel
+void evaluateNestedLogit(const double *utilities, const int *numOtherBids, int numSims,
+                         int maxOtherBids, const FocalBidTerms& focal, SimulationSums& sums);
+// The same for the multinomial logit: the nested logit with nestCorr fixed at 1 (focal.nestCorr and
+// focal.invNestCorr are ignored), compiled separately so that the nesting terms drop out
+void evaluateMultinomialLogit(const double *utilities, const int *numOtherBids, int numSims,
+                              int maxOtherBids, const FocalBidTerms& focal, SimulationSums& sums);
+
+
+// End header guard with endif statement
+#endif
@@ -0,0 +1,89 @@
+// random_streams.hpp
+// Counter-based random number streams for the auction simulations
+// Each stream is identified by (seed, bid index, unobserved auction type, simulation index) and
+// its draws are a pure function of that identity, so any simulation can be regenerated on its
+// own, on any thread, in any order.  The generator is Philox4x32-10 (Salmon et al. 2011,
+// "Parallel Random Numbers: As Easy as 1, 2, 3"), which passes BigCrush.
+// The member functions are defined here rather than in a .cpp file because they are called in
+// the innermost simulation loop and need to be inlined.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef RANDOM_STREAMS_INCLUDED
+#define RANDOM_STREAMS_INCLUDED
+
+#include <stdint.h>
+
+
+// Stream of uniform draws for one simulated auction
+class RandomStream {
+
+public:
+
+    // The seed is the key of the generator; the bid index, auction type, and simulation index
+    // fill out the counter, leaving the first word of the counter to count blocks of draws.  The
+    // counter only has room for the low 32 bits of the bid index, so the high bits are folded into
+    // the key (scattered by an odd multiplier so they don't line up with small changes to the seed);
+    // indices below 2^32 leave the key equal to the seed.
+    RandomStream(uint64_t seed, uint64_t bidIndex, uint32_t uAucType, uint32_t simIndex){
+        key[0] = (uint32_t)seed;
+        key[1] = (uint32_t)(seed >> 32) ^ ((uint32_t)(bidIndex >> 32) * 0x9E3779B9u);
+        counter[0] = 0;
+        counter[1] = simIndex;
+        counter[2] = uAucType;
+        counter[3] = (uint32_t)bidIndex;
+        numBuffered = 0;
+    }
+
+    // Uniform draw on [0, 1) using 53 random bits (the full precision of a double)
+    double nextUniform(){
+        if( numBuffered == 0 ){
+            refill();
+        }
+        numBuffered -= 2;
+        uint64_t bits = ((uint64_t)buffer[numBuffered + 1] << 32) | buffer[numBuffered];
+        return( (bits >> 11) * (1.0 / 9007199254740992.0) );
+    }
+
+    // Uniform draw from {0, ..., n - 1}
+    int nextIndex(int n){
+        int index = (int)(nextUniform() * n);
+        // Guard against rounding up to n when the uniform is within 2^-53 of 1
+        return( index < n ? index : n - 1 );
+    }
+
+private:
+
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t buffer[4];
+    int numBuffered;
+
+    // Encrypt the current counter with ten Philox rounds, then advance the block counter
+    void refill(){
+        uint32_t x0 = counter[0], x1 = counter[1], x2 = counter[2], x3 = counter[3];
+        uint32_t k0 = key[0], k1 = key[1];
+        for(int round = 0; round < 10; round++){
+            uint64_t product0 = (uint64_t)0xD2511F53 * x0;
+            uint64_t product1 = (uint64_t)0xCD9E8D57 * x2;
+            uint32_t y0 = (uint32_t)(product1 >> 32) ^ x1 ^ k0;
+            uint32_t y2 = (uint32_t)(product0 >> 32) ^ x3 ^ k1;
+            x1 = (uint32_t)product1;
+            x3 = (uint32_t)product0;
+            x0 = y0;
+            x2 = y2;
+            // Bump the key with the Weyl sequence constants
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        buffer[0] = x0;
+        buffer[1] = x1;
+        buffer[2] = x2;
+        buffer[3] = x3;
+        numBuffered = 4;
+        counter[0]++;
+    }
+};
+
+
+// End header guard with endif statement
+#endif
@@ -6,39 +6,63 @@
 # Run the script from the directory where it's located
 cd `dirname $0`
 
+# A checkpoint means that an earlier run of calculate_costs.exe was interrupted.  Keep its inputs
+# and outputs and resume it rather than starting over.
+if [[ -f estimated_costs.ckpt ]] ; then
+    echo "Resuming the interrupted cost calculation in estimated_costs.ckpt."
+    ./calculate_costs.exe --threads 0 --generate-samples --num-samples 100000 --resume
+    exit $?
+fi
+
 # Delete files from earlier runs (which would interfere with auction parameter inferences in calculate_costs.cpp)
-rm inv_cdf*.csv
-rm costs.csv
-rm coeff.txt
-rm unobs_auc_type_probs.csv
+rm -f inv_cdf*.csv
+rm -f costs.csv
+rm -f coeff.txt
+rm -f unobs_auc_type_probs.csv
+rm -f sample_bids.bin
+# Sample bid files left from a run with more types would be listed in the new manifest
+rm -f sample_bids_*.csv
+rm -f sample_bids_manifest.txt
 
 
 # Calculate the distribution of bids for each type of auction, taking
 # the number of unobserved auction types as a parameter.  The
-# parameter is given at the command line with three types as the
-# default.
+# parameter is given at the command line with one type as the
+# default.  calc_auction_type_probs.exe does what calc_auction_type_probs.m
+# did, with the same outputs, and doesn't need MATLAB.
+# To compile:
+# g++ -O2 -pthread -o calc_auction_type_probs.exe calc_auction_type_probs.cpp auction_type_probs.cpp weighted_kde.cpp bid_data_loader.cpp bid_selection.cpp alias_table.cpp competitor_draws.cpp sobol_sequence.cpp nested_logit_kernel.cpp
 if [[ $# == 1 ]] ; then
     echo "Running for $1 unobserved auction types."
-    matlab -nodisplay -nosplash -r "try, calc_auction_type_probs($1), catch, end, quit"
+    ./calc_auction_type_probs.exe --types $1 --threads 0 || exit 1
 else
     echo "No number of unobserved auction types given.  Running for default of 1 (no unobserved types)."
-    matlab -nodisplay -nosplash -r "try, calc_auction_type_probs(1), catch, end, quit"
+    ./calc_auction_type_probs.exe --types 1 --threads 0 || exit 1
 fi
 
 
 # Calculate bid selection probabilities using nested logit
-# This can be run without the auction types calculated in estimate_auction_type_probs.m
+# This can be run without the auction types calculated in calc_auction_type_probs.exe
 estimate_bid_selection.do
 
-# Sample bids for each type of bidder in each type of auction
-matlab -nodisplay -nosplash -r sample_bids.m
+# Sample bids for each type of bidder in each type of auction are drawn by calculate_costs.exe
+# itself (--generate-samples), from template_data.csv and unobs_auc_type_probs.csv, so no sample
+# bid files are written.  To use sample bid files written some other way instead, list them in a
+# manifest (types, sizes, and checksums) and convert them into a binary cache that
+# calculate_costs.exe maps, then replace --generate-samples below with --sample-cache sample_bids.bin:
+#   g++ -O2 -pthread -o convert_sample_bids.exe convert_sample_bids.cpp import_data.cpp alias_table.cpp sample_bid_store.cpp
+#   ./convert_sample_bids.exe --write-manifest --threads 0 --output sample_bids.bin
 
 # Use selection probabilities to solve for bidder costs
 # To compile:
-# g++ -o calculate_costs.exe calculate_costs.cpp bid_selection.cpp
-./calculate_costs.exe
+# g++ -O2 -pthread -o calculate_costs.exe calculate_costs.cpp bid_selection.cpp import_data.cpp alias_table.cpp sample_bid_store.cpp nested_logit_kernel.cpp competitor_draws.cpp sobol_sequence.cpp bid_data_loader.cpp checkpoint.cpp inclusive_value_table.cpp run_report.cpp cost_shards.cpp sample_bid_generator.cpp weighted_kde.cpp cost_bootstrap.cpp auction_type_probs.cpp
+# Use every available core (results do not depend on the number of threads)
+./calculate_costs.exe --threads 0 --generate-samples --num-samples 100000
+# To spread the work over N machines sharing this directory instead, run
+#   ./calculate_costs.exe --threads 0 --generate-samples --num-samples 100000 --shard i/N
+# for i = 1, ..., N (e.g. as the tasks of a batch job), then
+#   ./merge_cost_shards.exe --shards N
 
 
 ## TODO
-## Implement sample_bids.m, or keep it as a wrapper to be filled in later
-## Change calculate_costs.exe to sample bids from the files of sample bids for each type
+## Sample the other bid traits sketched in sample_bids.m if the selection model starts using them
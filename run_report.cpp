@@ -0,0 +1,147 @@
+// run_report.cpp
+// Implementing the run instrumentation declared in run_report.hpp
+
+#include "run_report.hpp"
+#include <stdio.h>
+#include <iostream>
+
+
+using namespace std;
+
+
+// Seconds between two times
+static double secondsBetween(chrono::steady_clock::time_point start, chrono::steady_clock::time_point end){
+    return( chrono::duration<double>(end - start).count() );
+}
+
+
+RunReport::RunReport(){
+    runStart = chrono::steady_clock::now();
+    phaseStart = runStart;
+    progressStart = runStart;
+    currentPhase = NULL;
+    progressTotal = 0;
+    counters.bidsProcessed.store(0);
+    counters.simulations.store(0);
+    counters.competitorsDrawn.store(0);
+    counters.expLogCalls.store(0);
+}
+
+
+void RunReport::beginPhase(const char *name){
+    endPhase();
+    currentPhase = name;
+    phaseStart = chrono::steady_clock::now();
+}
+
+void RunReport::endPhase(){
+    if( currentPhase == NULL ){
+        return;
+    }
+    // A phase that is timed more than once (e.g. on both sides of a branch) adds up
+    double seconds = secondsBetween(phaseStart, chrono::steady_clock::now());
+    for(size_t p = 0; p < phaseNames.size(); p++){
+        if( phaseNames[p] == currentPhase ){
+            phaseSeconds[p] += seconds;
+            currentPhase = NULL;
+            return;
+        }
+    }
+    phaseNames.push_back(currentPhase);
+    phaseSeconds.push_back(seconds);
+    currentPhase = NULL;
+}
+
+
+void RunReport::setInfo(const char *key, const string& value){
+    // Quote the string, escaping the characters JSON doesn't allow inside one
+    string quoted = "\"";
+    for(size_t c = 0; c < value.size(); c++){
+        if( (value[c] == '"') || (value[c] == '\\') ){
+            quoted += '\\';
+            quoted += value[c];
+        } else if( (unsigned char)value[c] < 0x20 ){
+            char escaped[8];
+            sprintf(escaped, "\\u%04x", value[c]);
+            quoted += escaped;
+        } else {
+            quoted += value[c];
+        }
+    }
+    quoted += "\"";
+    infoKeys.push_back(key);
+    infoValues.push_back(quoted);
+}
+
+void RunReport::setInfo(const char *key, double value){
+    char formatted[32];
+    snprintf(formatted, sizeof(formatted), "%.17g", value);
+    infoKeys.push_back(key);
+    infoValues.push_back(formatted);
+}
+
+
+void RunReport::startProgress(long long totalBids){
+    progressTotal = totalBids;
+    progressStart = chrono::steady_clock::now();
+}
+
+void RunReport::printProgress() const {
+
+    double elapsed = secondsBetween(progressStart, chrono::steady_clock::now());
+    long long bidsDone = counters.bidsProcessed.load(memory_order_relaxed);
+    long long simsDone = counters.simulations.load(memory_order_relaxed);
+    double share = (progressTotal > 0 ? (double)bidsDone / progressTotal : 1);
+
+    fprintf(stderr, "Progress: %lld of %lld bids (%.1f%%), %.3g simulations/s", bidsDone, progressTotal,
+            100 * share, simsDone / max(elapsed, 1e-9));
+    // The time left assumes the remaining bids go at the average pace so far
+    if( bidsDone > 0 ){
+        long long secondsLeft = (long long)(elapsed * (1 - share) / share + 0.5);
+        fprintf(stderr, ", about %lld:%02lld:%02lld left", secondsLeft / 3600, (secondsLeft / 60) % 60,
+                secondsLeft % 60);
+    }
+    fprintf(stderr, "\n");
+}
+
+
+bool RunReport::writeJson(const char *fileName) const {
+
+    FILE *outFile = fopen(fileName, "w");
+    if( outFile == NULL ){
+        cout << "Error: could not write " << fileName << ".\n";
+        return( false );
+    }
+
+    double totalSeconds = secondsBetween(runStart, chrono::steady_clock::now());
+    double simSeconds = 0;
+    fprintf(outFile, "{\n");
+    for(size_t i = 0; i < infoKeys.size(); i++){
+        fprintf(outFile, "  \"%s\": %s,\n", infoKeys[i].c_str(), infoValues[i].c_str());
+    }
+    fprintf(outFile, "  \"total_seconds\": %.6f,\n", totalSeconds);
+    fprintf(outFile, "  \"phase_seconds\": {");
+    for(size_t p = 0; p < phaseNames.size(); p++){
+        fprintf(outFile, "%s\n    \"%s\": %.6f", (p > 0 ? "," : ""), phaseNames[p], phaseSeconds[p]);
+        if( string(phaseNames[p]) == "simulate" ){
+            simSeconds = phaseSeconds[p];
+        }
+    }
+    fprintf(outFile, "\n  },\n");
+    long long simulations = counters.simulations.load();
+    fprintf(outFile, "  \"counters\": {\n");
+    fprintf(outFile, "    \"bids_processed\": %lld,\n", counters.bidsProcessed.load());
+    fprintf(outFile, "    \"simulations\": %lld,\n", simulations);
+    fprintf(outFile, "    \"competitors_drawn\": %lld,\n", counters.competitorsDrawn.load());
+    fprintf(outFile, "    \"exp_log_calls\": %lld\n", counters.expLogCalls.load());
+    fprintf(outFile, "  },\n");
+    fprintf(outFile, "  \"simulations_per_second\": %.6g\n", simSeconds > 0 ? simulations / simSeconds : 0.0);
+    fprintf(outFile, "}\n");
+
+    bool failed = (ferror(outFile) != 0);
+    failed |= (fclose(outFile) != 0);
+    if( failed ){
+        cout << "Error: could not finish writing " << fileName << ".\n";
+    }
+    return( !failed );
+}
@@ -0,0 +1,86 @@
+// run_report.hpp
+// Instrumentation for calculate_costs.exe runs: wall-clock timers around each phase (reading the
+// sample bid manifest, importing, loading the bids, simulating, writing the output), counters of the
+// work done, progress lines with the throughput and estimated time left, and a JSON summary.  The
+// simulation threads add to the counters once per bid (or batch), not per simulation, so the
+// instrumentation costs a few atomic additions per bid and can stay on.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef RUN_REPORT_INCLUDED
+#define RUN_REPORT_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+// Work done by the simulation threads.  Each counter is on its own cache line so that threads
+// adding to different counters don't slow each other down.
+//   bidsProcessed: bids whose simulations finished in this run (not outside options, bids that
+//                  reuse another bid's simulations, or bids finished by a resumed checkpoint)
+//   simulations: simulated auctions evaluated, summed over bids and unobserved auction types (table
+//                entries count as simulations in --inclusive-table runs)
+//   competitorsDrawn: competitors drawn into banks (number, bidder type, and sample row each)
+//   expLogCalls: calls to exp() and log() in the selection kernel; each simulation takes one exp per
+//                competitor, one for the focal bid, one for the nest, and one log
+typedef struct {
+    alignas(64) std::atomic<long long> bidsProcessed;
+    alignas(64) std::atomic<long long> simulations;
+    alignas(64) std::atomic<long long> competitorsDrawn;
+    alignas(64) std::atomic<long long> expLogCalls;
+} RunCounters;
+
+// exp() and log() calls in the selection kernel for numSims simulations with numCompetitors
+// competitors in all.  The nested and multinomial logit share the kernel (the multinomial logit
+// only skips the multiplications by nestCorr), so the count is the same for both models; a model
+// with a different kernel needs its own count.
+inline long long logitExpLogCalls(long long numSims, long long numCompetitors){
+    return( numCompetitors + 3*numSims );
+}
+
+
+class RunReport {
+
+public:
+
+    // Start the clock for the whole run, with all counters at zero
+    RunReport();
+
+    // Start timing a phase, ending the one before it.  Names should be valid JSON keys.
+    void beginPhase(const char *name);
+    // End the current phase without starting another
+    void endPhase();
+
+    // Record a setting or other fact about the run for the JSON summary
+    void setInfo(const char *key, const std::string& value);
+    void setInfo(const char *key, double value);
+
+    // Work done so far, added to by the simulation threads
+    RunCounters counters;
+
+    // Start measuring progress toward totalBids processed bids (call when the simulations start)
+    void startProgress(long long totalBids);
+    // Print the bids processed, simulations per second, and estimated time left to stderr
+    void printProgress() const;
+
+    // Write the phases, counters, and recorded facts to fileName as JSON.  Returns false (after
+    // printing an error) if the file can't be written.
+    bool writeJson(const char *fileName) const;
+
+private:
+
+    std::chrono::steady_clock::time_point runStart;
+    std::chrono::steady_clock::time_point phaseStart;
+    std::chrono::steady_clock::time_point progressStart;
+    const char *currentPhase;
+    std::vector<const char*> phaseNames;
+    std::vector<double> phaseSeconds;
+    std::vector<std::string> infoKeys;
+    std::vector<std::string> infoValues; // already formatted as JSON values
+    long long progressTotal;
+};
+
+
+// End header guard with endif statement
+#endif
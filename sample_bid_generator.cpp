@@ -0,0 +1,258 @@
+// sample_bid_generator.cpp
+// Implementing the sample bid generation declared in sample_bid_generator.hpp
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "sample_bid_generator.hpp"
+#include "weighted_kde.hpp"
+#include "import_data.hpp"
+#include <string>
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+// Stream type of the sample bid draws, distinct from the unobserved auction types that key the
+// simulations' streams and from the other reserved stream types
+static const uint32_t sampleBidStream = 0xFFFFFFFD;
+
+// Sample bids drawn in each task
+static const int samplesPerTask = 65536;
+
+
+// Run task(t) for t = 0, ..., numTasks - 1 on numThreads threads, each taking the next task from a
+// shared counter, as in auction_type_probs.cpp
+template <typename Task>
+static void runTasks(int numTasks, int numThreads, const Task& task){
+    atomic<int> nextTask(0);
+    auto worker = [&](){
+        for(int t = nextTask.fetch_add(1); t < numTasks; t = nextTask.fetch_add(1)){
+            task(t);
+        }
+    };
+    vector<thread> threads;
+    for(int t = 1; t < min(numThreads, numTasks); t++){
+        threads.push_back( thread(worker) );
+    }
+    worker();
+    for(size_t t = 0; t < threads.size(); t++){
+        threads[t].join();
+    }
+}
+
+// Run task(t, error) for tasks that can fail.  Errors are printed in task order once every task is
+// done, as in import_data.cpp.  Returns false if any task set an error.
+template <typename Task>
+static bool runOnTasks(int numTasks, int numThreads, const Task& task){
+
+    vector<string> errors(numTasks);
+    runTasks(numTasks, numThreads, [&](int t){
+        task(t, errors[t]);
+    });
+
+    bool failed = false;
+    for(int t = 0; t < numTasks; t++){
+        if( !errors[t].empty() ){
+            cout << "Error: " << errors[t] << ".\n";
+            failed = true;
+        }
+    }
+    return( !failed );
+}
+
+
+bool readTypeProbs(const char *fileName, int& numUnobsAucTypes, vector<double>& typeProbs){
+
+    ifstream infile(fileName);
+    string line;
+    if( !infile.is_open() || !getline(infile, line) ){
+        cout << "Error: could not read " << fileName << ".\n";
+        return( false );
+    }
+
+    // One column per type in the header
+    numUnobsAucTypes = count(line.begin(), line.end(), ',') + 1;
+    typeProbs.clear();
+    int lineNumber = 1;
+    while( getline(infile, line) ){
+        lineNumber++;
+        if( line.find_first_not_of(" \t\r") == string::npos ){
+            continue;
+        }
+        const char *field = line.c_str();
+        for(int k = 0; k < numUnobsAucTypes; k++){
+            char *end;
+            double prob = strtod(field, &end);
+            while( (*end == ' ') || (*end == '\t') || (*end == '\r') ){
+                end++;
+            }
+            bool lastField = (k == numUnobsAucTypes - 1);
+            if( (end == field) || (*end != (lastField ? '\0' : ',')) ){
+                cout << "Error: line " << lineNumber << " of " << fileName << " doesn't have "
+                     << numUnobsAucTypes << " probabilities.\n";
+                return( false );
+            }
+            typeProbs.push_back(prob);
+            field = end + 1;
+        }
+    }
+    return( true );
+}
+
+
+bool generateSampleBids(SampleBidStore& sampleBids, const vector<Bid>& bids, const vector<double>& typeProbs,
+                        int numUnobsAucTypes, int numSamples, const SampleBidSettings& settings, int numThreads){
+
+    // Only sample bids that are not the outside option; their type probabilities are the rows of
+    // typeProbs in order
+    int K = numUnobsAucTypes;
+    vector<size_t> rows;
+    AucTraits aucTraits;
+    aucTraits.numBidderTypes = 0;
+    aucTraits.numObsAucTypes = 0;
+    aucTraits.numUnobsAucTypes = K;
+    double minAmount = HUGE_VAL;
+    double maxAmount = -HUGE_VAL;
+    for(size_t i = 0; i < bids.size(); i++){
+        if( bids[i].bidderType <= 0 ){
+            continue;
+        }
+        if( bids[i].obsAucType <= 0 ){
+            cout << "Error: bid " << i + 1 << " has observed auction type " << bids[i].obsAucType
+                 << "; types must be at least 1.\n";
+            return( false );
+        }
+        rows.push_back(i);
+        aucTraits.numBidderTypes = max(aucTraits.numBidderTypes, bids[i].bidderType);
+        aucTraits.numObsAucTypes = max(aucTraits.numObsAucTypes, bids[i].obsAucType);
+        minAmount = min(minAmount, bids[i].amount);
+        maxAmount = max(maxAmount, bids[i].amount);
+    }
+    if( rows.empty() || (rows.size()*K != typeProbs.size()) ){
+        cout << "Error: there are " << rows.size() << " bids other than the outside option but "
+             << typeProbs.size() / K << " rows of type probabilities.\n";
+        return( false );
+    }
+
+    // Points of the inverse CDFs and the support, as in the MATLAB sketch: from 10 below the
+    // smallest bid (but at least 1) to 1.05 times the largest, with the support starting 1 lower
+    vector<double> points(max(settings.gridPoints, 2));
+    double firstPoint = max(1.0, minAmount - 10);
+    double lastPoint = 1.05*maxAmount;
+    for(size_t j = 0; j < points.size(); j++){
+        points[j] = (j + 1 == points.size() ? lastPoint : firstPoint + j*(lastPoint - firstPoint)/(points.size() - 1));
+    }
+    KdeSettings kdeSettings;
+    kdeSettings.lower = firstPoint - 1;
+    kdeSettings.upper = lastPoint;
+    kdeSettings.bandwidth = settings.bandwidth;
+    kdeSettings.lowProb = 0;
+    kdeSettings.numBins = settings.kdeBins;
+
+    // List the rows of each (bidder type, observed auction type) pair with a counting sort
+    int numPairs = aucTraits.numBidderTypes*aucTraits.numObsAucTypes;
+    vector<size_t> pairStart(numPairs + 1, 0);
+    for(size_t n = 0; n < rows.size(); n++){
+        pairStart[(bids[rows[n]].bidderType - 1)*aucTraits.numObsAucTypes + bids[rows[n]].obsAucType]++;
+    }
+    for(int p = 0; p < numPairs; p++){
+        pairStart[p + 1] += pairStart[p];
+    }
+    vector<size_t> pairRows(rows.size());
+    vector<size_t> nextRow(pairStart.begin(), pairStart.end() - 1);
+    for(size_t n = 0; n < rows.size(); n++){
+        pairRows[nextRow[(bids[rows[n]].bidderType - 1)*aucTraits.numObsAucTypes + bids[rows[n]].obsAucType - 1]++] = n;
+    }
+
+    // CDF of each cell at the points: one density estimate per pair gives every unobserved type,
+    // integrated with the trapezoid rule and scaled to end at one
+    sampleBids.allocate(aucTraits, numSamples);
+    vector< vector<double> > cdfs(sampleBids.numCells());
+    bool estimated = runOnTasks(numPairs, numThreads, [&](int p, string& error){
+        int i = p / aucTraits.numObsAucTypes;
+        int j = p % aucTraits.numObsAucTypes;
+        WeightedKde kde(kdeSettings, points, K);
+        for(size_t n = pairStart[p]; n < pairStart[p + 1]; n++){
+            kde.add(bids[rows[pairRows[n]]].amount, &typeProbs[pairRows[n]*K]);
+        }
+        vector<double> densities;
+        kde.densities(densities);
+        for(int k = 0; k < K; k++){
+            const double *density = &densities[k*points.size()];
+            vector<double>& cdf = cdfs[sampleBids.cellIndex(i, j, k)];
+            cdf.assign(points.size(), 0);
+            for(size_t m = 1; m < points.size(); m++){
+                cdf[m] = cdf[m - 1] + 0.5*(density[m - 1] + density[m])*(points[m] - points[m - 1]);
+            }
+            double total = cdf.back();
+            if( !(total > 0) ){
+                error = "no bids of bidder type " + to_string(i + 1) + " in observed auction type " +
+                    to_string(j + 1) + " have weight in unobserved auction type " + to_string(k + 1);
+                return;
+            }
+            for(size_t m = 0; m < points.size(); m++){
+                cdf[m] /= total;
+            }
+        }
+    });
+    if( !estimated ){
+        return( false );
+    }
+
+    // Invert the CDFs at uniform draws, interpolating between the points around each draw
+    int tasksPerCell = (numSamples + samplesPerTask - 1) / samplesPerTask;
+    runTasks(sampleBids.numCells()*tasksPerCell, numThreads, [&](int t){
+        int cell = t / tasksPerCell;
+        int bidderType = cell / (aucTraits.numObsAucTypes*K);
+        const vector<double>& cdf = cdfs[cell];
+        Bid sampleBid = Bid();
+        sampleBid.bidderType = bidderType + 1;
+        int end = min(numSamples, (t % tasksPerCell + 1)*samplesPerTask);
+        for(int row = (t % tasksPerCell)*samplesPerTask; row < end; row++){
+            RandomStream draws(settings.seed, cell, sampleBidStream, row);
+            double u = draws.nextUniform();
+            size_t m = upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+            m = min(max(m, (size_t)1), cdf.size() - 1);
+            double share = (cdf[m] > cdf[m - 1] ? (u - cdf[m - 1]) / (cdf[m] - cdf[m - 1]) : 0);
+            sampleBid.amount = points[m - 1] + share*(points[m] - points[m - 1]);
+            sampleBids.setBid(cell, row, sampleBid);
+        }
+    });
+
+    cout << "Drew " << numSamples << " sample bids for each of " << sampleBids.numCells() << " cells\n";
+    return( true );
+}
+
+
+bool exportSampleBids(const SampleBidStore& sampleBids, const char *manifestFile, int numThreads){
+
+    AucTraits aucTraits = sampleBids.aucTraits();
+    bool written = runOnTasks(sampleBids.numCells(), numThreads, [&](int cell, string& error){
+        int k = cell % aucTraits.numUnobsAucTypes;
+        int j = (cell / aucTraits.numUnobsAucTypes) % aucTraits.numObsAucTypes;
+        int i = cell / (aucTraits.numUnobsAucTypes*aucTraits.numObsAucTypes);
+        char fileName[100];
+        sprintf(fileName, "sample_bids_btype_%d_oauctype_%d_uauctype_%d.csv", i + 1, j + 1, k + 1);
+        FILE *outFile = fopen(fileName, "w");
+        if( outFile == NULL ){
+            error = string("could not write ") + fileName;
+            return;
+        }
+        fprintf(outFile, "BidAmount, BidderType\n");
+        for(int row = 0; row < sampleBids.numSamples(); row++){
+            fprintf(outFile, "%.17g, %d\n", sampleBids.amount(cell, row), sampleBids.bidderType(cell, row));
+        }
+        bool failed = (ferror(outFile) != 0);
+        failed |= (fclose(outFile) != 0);
+        if( failed ){
+            error = string("could not finish writing ") + fileName;
+        }
+    });
+
+    // The manifest records the files' sizes and checksums, so it is written after them
+    if( !written || !writeSampleBidManifest(manifestFile, aucTraits, numThreads) ){
+        return( false );
+    }
+    cout << "Exported " << sampleBids.numCells() << " cells of sample bids and " << manifestFile << "\n";
+    return( true );
+}
@@ -0,0 +1,52 @@
+// sample_bid_generator.hpp
+// Drawing the sample bids of every (bidder type, observed auction type, unobserved auction type)
+// cell straight into a SampleBidStore, in place of sample_bids.m and the sample_bids_*.csv files.
+// As in the inverse CDFs sketched at the end of calc_auction_type_probs.m, the bid amounts of each
+// bidder type and observed auction type in template_data.csv get a weighted kernel density for
+// each unobserved type (weighted by the bids' rows of unobs_auc_type_probs.csv, with bandwidth 0.1
+// and bounded support), which is integrated into an inverse CDF and sampled.  Of the columns in
+// sample_bids.m, the bidder type is discrete and fixed by the cell, and the amount is the
+// continuous column that is drawn; the store keeps no other bid fields, since the competitors'
+// utilities only use those two.
+// Sample i of a cell comes from the random stream keyed by (seed, cell, i), so the samples don't
+// depend on the number of threads and the first N of a larger sample are a sample of N.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef SAMPLE_BID_GENERATOR_INCLUDED
+#define SAMPLE_BID_GENERATOR_INCLUDED
+
+#include <stdint.h>
+#include <vector>
+#include "bid_selection.hpp"
+#include "sample_bid_store.hpp"
+
+
+// Settings of the generator
+typedef struct {
+    int gridPoints;     // points of each inverse CDF (4096)
+    double bandwidth;   // kernel bandwidth on the log-odds scale (0.1, as in the MATLAB code)
+    int kdeBins;        // nodes of the binned density estimate (16384; see weighted_kde.hpp)
+    uint64_t seed;      // seed of the random streams
+} SampleBidSettings;
+
+// Read unobs_auc_type_probs.csv (as written by calc_auction_type_probs.exe): the number of
+// unobserved types, and each row's probabilities one row after another.  Returns false (after
+// printing an error) if the file can't be read or a row doesn't have one probability per type.
+bool readTypeProbs(const char *fileName, int& numUnobsAucTypes, std::vector<double>& typeProbs);
+
+// Allocate numSamples sample bids per cell in sampleBids and draw them from the bids other than the
+// outside option, whose type probabilities are the rows of typeProbs in order.  The numbers of
+// bidder and observed auction types are the largest in the bids.  Returns false (after printing
+// an error) if the number of bids doesn't match the rows of typeProbs or any cell has no bids to
+// draw from.
+bool generateSampleBids(SampleBidStore& sampleBids, const std::vector<Bid>& bids, const std::vector<double>& typeProbs,
+                        int numUnobsAucTypes, int numSamples, const SampleBidSettings& settings, int numThreads);
+
+// Write the store to sample_bids_*.csv files and their manifest for inspection (or to be imported
+// later), numThreads files at a time.  Amounts are written with enough digits to be read back
+// exactly.  Returns false (after printing an error) if a file can't be written.
+bool exportSampleBids(const SampleBidStore& sampleBids, const char *manifestFile, int numThreads);
+
+
+// End header guard with endif statement
+#endif
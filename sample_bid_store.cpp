@@ -0,0 +1,234 @@
+// sample_bid_store.cpp
+// Implementing the sample bid storage declared in sample_bid_store.hpp
+
+#include "sample_bid_store.hpp"
+#include "checkpoint.hpp" // For hashBytes(), the column checksums
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+using namespace std;
+
+
+// Alignment of the arena and of every cell within a column (one cache line)
+static const size_t storeAlignment = 64;
+
+// Round a byte count up to a multiple of the alignment
+static size_t alignUp(size_t numBytes){
+    return( (numBytes + storeAlignment - 1) / storeAlignment * storeAlignment );
+}
+
+
+//// Cache file format
+// A fixed header, then the amount column and the bidder type column, each starting on a 64-byte
+// boundary and laid out exactly as in memory (including the padding rows, which are zero).  Numbers
+// are in the byte order of the machine that wrote the file; byteOrder catches a mismatch.
+
+static const char sampleCacheMagic[8] = {'B', 'C', 'A', 'S', 'B', 'I', 'D', 'S'};
+static const uint32_t sampleCacheVersion = 2;
+static const uint32_t sampleCacheByteOrder = 0x01020304;
+
+typedef struct {
+    char magic[8];               // sampleCacheMagic
+    uint32_t version;            // sampleCacheVersion
+    uint32_t byteOrder;          // sampleCacheByteOrder as written by this machine
+    int32_t numBidderTypes;
+    int32_t numObsAucTypes;
+    int32_t numUnobsAucTypes;
+    int32_t samplesPerCell;      // sample bids in each cell
+    uint64_t rowStride;          // rows reserved per cell
+    uint64_t amountOffset;       // position of the amount column in the file
+    uint64_t amountBytes;
+    uint64_t bidderTypeOffset;   // position of the bidder type column in the file
+    uint64_t bidderTypeBytes;
+    uint64_t amountChecksum;     // FNV-1a hash of the amount column
+    uint64_t bidderTypeChecksum; // FNV-1a hash of the bidder type column
+    uint64_t fileBytes;          // length of the whole file
+} SampleCacheHeader;
+
+
+// Allocate one arena holding every column
+SampleBidStore::SampleBidStore(AucTraits aucTraits, int numSamples){
+    arena = NULL;
+    mappedBytes = 0;
+    allocate(aucTraits, numSamples);
+}
+
+void SampleBidStore::allocate(AucTraits aucTraits, int numSamples){
+
+    release();
+    numBidderTypes = aucTraits.numBidderTypes;
+    numObsAucTypes = aucTraits.numObsAucTypes;
+    numUnobsAucTypes = aucTraits.numUnobsAucTypes;
+    samplesPerCell = numSamples;
+
+    // Pad each cell to a whole number of cache lines in the narrowest column (int32_t), which is
+    // then also a whole number of cache lines in the wider columns
+    size_t rowsPerLine = storeAlignment / sizeof(int32_t);
+    rowStride = (numSamples + rowsPerLine - 1) / rowsPerLine * rowsPerLine;
+
+    size_t numRows = rowStride * numCells();
+    size_t amountBytes = alignUp(numRows * sizeof(double));
+    size_t bidderTypeBytes = alignUp(numRows * sizeof(int32_t));
+    arenaBytes = amountBytes + bidderTypeBytes;
+
+    arena = (char*)aligned_alloc(storeAlignment, max(arenaBytes, storeAlignment));
+    if( arena == NULL ){
+        cout << "Error: could not allocate " << arenaBytes << " bytes for sample bids.\n";
+        exit(1);
+    }
+    // Zero the padding rows so that saved caches have the same checksums from run to run
+    memset(arena, 0, arenaBytes);
+    mappedBytes = 0;
+    amounts = (double*)arena;
+    bidderTypes = (int32_t*)(arena + amountBytes);
+}
+
+SampleBidStore::SampleBidStore(){
+    numBidderTypes = 0;
+    numObsAucTypes = 0;
+    numUnobsAucTypes = 0;
+    samplesPerCell = 0;
+    rowStride = 0;
+    arena = NULL;
+    arenaBytes = 0;
+    mappedBytes = 0;
+    amounts = NULL;
+    bidderTypes = NULL;
+}
+
+SampleBidStore::~SampleBidStore(){
+    release();
+}
+
+void SampleBidStore::release(){
+    if( mappedBytes > 0 ){
+        munmap(arena, mappedBytes);
+    } else {
+        free(arena);
+    }
+    arena = NULL;
+    arenaBytes = 0;
+    mappedBytes = 0;
+}
+
+
+// Write the header and both columns
+bool SampleBidStore::writeCache(const char *fileName) const {
+
+    size_t amountBytes = (char*)bidderTypes - (char*)amounts;
+    size_t bidderTypeBytes = arenaBytes - amountBytes;
+
+    SampleCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, sampleCacheMagic, sizeof(header.magic));
+    header.version = sampleCacheVersion;
+    header.byteOrder = sampleCacheByteOrder;
+    header.numBidderTypes = numBidderTypes;
+    header.numObsAucTypes = numObsAucTypes;
+    header.numUnobsAucTypes = numUnobsAucTypes;
+    header.samplesPerCell = samplesPerCell;
+    header.rowStride = rowStride;
+    header.amountOffset = alignUp(sizeof(header));
+    header.amountBytes = amountBytes;
+    header.bidderTypeOffset = header.amountOffset + amountBytes;
+    header.bidderTypeBytes = bidderTypeBytes;
+    header.amountChecksum = hashBytes(amounts, amountBytes, fnvOffsetBasis);
+    header.bidderTypeChecksum = hashBytes(bidderTypes, bidderTypeBytes, fnvOffsetBasis);
+    header.fileBytes = header.bidderTypeOffset + bidderTypeBytes;
+
+    FILE *cacheFile = fopen(fileName, "wb");
+    if( cacheFile == NULL ){
+        cout << "Error: could not open " << fileName << " for writing.\n";
+        return( false );
+    }
+    char padding[storeAlignment] = {0};
+    bool ok = (fwrite(&header, sizeof(header), 1, cacheFile) == 1) &&
+        (fwrite(padding, header.amountOffset - sizeof(header), 1, cacheFile) == 1) &&
+        (fwrite(amounts, 1, amountBytes, cacheFile) == amountBytes) &&
+        (fwrite(bidderTypes, 1, bidderTypeBytes, cacheFile) == bidderTypeBytes);
+    ok = (fclose(cacheFile) == 0) && ok;
+    if( !ok ){
+        cout << "Error: could not write " << fileName << ".\n";
+    }
+    return( ok );
+}
+
+
+// Map the cache file and check it before pointing the columns into it
+bool SampleBidStore::mapCache(const char *fileName, int numSamples, bool verifyChecksums){
+
+    int fd = open(fileName, O_RDONLY);
+    if( fd < 0 ){
+        cout << "Error: could not open " << fileName << ".\n";
+        return( false );
+    }
+    struct stat fileStats;
+    if( (fstat(fd, &fileStats) != 0) || ((size_t)fileStats.st_size < sizeof(SampleCacheHeader)) ){
+        cout << "Error: " << fileName << " is too short to be a sample bid cache.\n";
+        close(fd);
+        return( false );
+    }
+    size_t fileBytes = fileStats.st_size;
+    char *mapped = (char*)mmap(NULL, fileBytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if( mapped == MAP_FAILED ){
+        cout << "Error: could not map " << fileName << ".\n";
+        return( false );
+    }
+
+    // Check the header and that the columns fit in the file; hashing the columns reads all of it, so
+    // it is only done on request
+    SampleCacheHeader header;
+    memcpy(&header, mapped, sizeof(header));
+    const char *problem = NULL;
+    if( memcmp(header.magic, sampleCacheMagic, sizeof(header.magic)) != 0 ){
+        problem = "is not a sample bid cache";
+    } else if( header.version != sampleCacheVersion ){
+        problem = "was written by a different version of convert_sample_bids";
+    } else if( header.byteOrder != sampleCacheByteOrder ){
+        problem = "was written on a machine with a different byte order";
+    } else if( (header.fileBytes != fileBytes) ||
+               (header.amountOffset % storeAlignment != 0) || (header.bidderTypeOffset % storeAlignment != 0) ||
+               (header.amountOffset + header.amountBytes > fileBytes) ||
+               (header.bidderTypeOffset + header.bidderTypeBytes > fileBytes) ||
+               (header.numBidderTypes <= 0) || (header.numObsAucTypes <= 0) || (header.numUnobsAucTypes <= 0) ||
+               (header.rowStride < (uint64_t)header.samplesPerCell) ||
+               (header.amountBytes < header.rowStride*header.numBidderTypes*header.numObsAucTypes*
+                                     header.numUnobsAucTypes*sizeof(double)) ||
+               (header.bidderTypeBytes < header.rowStride*header.numBidderTypes*header.numObsAucTypes*
+                                         header.numUnobsAucTypes*sizeof(int32_t)) ){
+        problem = "is truncated or has an inconsistent header";
+    } else if( verifyChecksums &&
+               ((hashBytes(mapped + header.amountOffset, header.amountBytes, fnvOffsetBasis) != header.amountChecksum) ||
+                (hashBytes(mapped + header.bidderTypeOffset, header.bidderTypeBytes, fnvOffsetBasis) !=
+                 header.bidderTypeChecksum)) ){
+        problem = "fails its checksums";
+    } else if( header.samplesPerCell < numSamples ){
+        cout << "Error: " << fileName << " has " << header.samplesPerCell << " sample bids per cell; expected "
+             << numSamples << ".\n";
+        munmap(mapped, fileBytes);
+        return( false );
+    }
+    if( problem != NULL ){
+        cout << "Error: " << fileName << " " << problem << ".\n";
+        munmap(mapped, fileBytes);
+        return( false );
+    }
+
+    // Replace the current storage with the file
+    release();
+    numBidderTypes = header.numBidderTypes;
+    numObsAucTypes = header.numObsAucTypes;
+    numUnobsAucTypes = header.numUnobsAucTypes;
+    samplesPerCell = numSamples;
+    rowStride = header.rowStride;
+    arena = mapped;
+    arenaBytes = header.amountBytes + header.bidderTypeBytes;
+    mappedBytes = fileBytes;
+    amounts = (double*)(mapped + header.amountOffset);
+    bidderTypes = (int32_t*)(mapped + header.bidderTypeOffset);
+    return( true );
+}
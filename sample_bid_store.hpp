@@ -0,0 +1,116 @@
+// sample_bid_store.hpp
+// Storage for the sample bids drawn as competitors in simulated auctions
+// All sample bids live in one contiguous, 64-byte-aligned block laid out as structure-of-arrays:
+// one column per bid field, and within each column one block of rows per (bidder type, observed
+// auction type, unobserved auction type) cell.  A competitor draw then touches a single cache line
+// of the amount column instead of a whole Bid reached through four levels of vectors.
+// The same layout is saved as a binary cache file (see convert_sample_bids.cpp), which a store can
+// map read-only instead of parsing the CSV files: startup then only checks the header, and
+// processes running at the same time share one copy in the page cache.  The column checksums are
+// verified when convert_sample_bids.exe writes the cache, and on request after that.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef SAMPLE_BID_STORE_INCLUDED
+#define SAMPLE_BID_STORE_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bid_selection.hpp"
+
+
+class SampleBidStore {
+
+public:
+
+    // Allocate zeroed storage for numSamples bids in every type cell
+    SampleBidStore(AucTraits aucTraits, int numSamples);
+    // Start with no storage, to be filled by allocate() or mapCache()
+    SampleBidStore();
+    ~SampleBidStore();
+
+    // Replace the current storage with zeroed storage for numSamples bids in every type cell
+    void allocate(AucTraits aucTraits, int numSamples);
+
+    // Save the store as a cache file.  Returns false (after printing an error) if it can't be written.
+    bool writeCache(const char *fileName) const;
+    // Map a cache file read-only in place of the current storage, using the first numSamples rows of
+    // each cell.  Returns false (after printing an error) if the file is missing, from another
+    // version, has a header that doesn't match its size, or has fewer than numSamples rows per cell.
+    // With verifyChecksums the columns are also hashed (a pass over the whole file) and the file is
+    // rejected if they don't match the checksums in the header.
+    bool mapCache(const char *fileName, int numSamples, bool verifyChecksums);
+
+    // Index of the cell for a bidder type, observed auction type, and unobserved auction type
+    // (all indexed from 0)
+    int cellIndex(int bidderType, int obsAucType, int uAucType) const {
+        return( (bidderType*numObsAucTypes + obsAucType)*numUnobsAucTypes + uAucType );
+    }
+
+    // Amount of a sample bid, given its cell and row
+    double amount(int cell, int row) const {
+        return( amounts[(size_t)cell*rowStride + row] );
+    }
+    // Bidder type (indexed from 1, as in the data) of a sample bid, given its cell and row
+    int bidderType(int cell, int row) const {
+        return( bidderTypes[(size_t)cell*rowStride + row] );
+    }
+
+    // Store the bid-specific fields of a sample bid; auction-specific fields are ignored
+    void setBid(int cell, int row, const Bid& bid){
+        amounts[(size_t)cell*rowStride + row] = bid.amount;
+        bidderTypes[(size_t)cell*rowStride + row] = bid.bidderType;
+    }
+
+    // Number of sample bids in each cell
+    int numSamples() const {
+        return( samplesPerCell );
+    }
+    // Total number of cells
+    int numCells() const {
+        return( numBidderTypes*numObsAucTypes*numUnobsAucTypes );
+    }
+    // Bidder and auction type counts of the store
+    AucTraits aucTraits() const {
+        AucTraits traits;
+        traits.numBidderTypes = numBidderTypes;
+        traits.numObsAucTypes = numObsAucTypes;
+        traits.numUnobsAucTypes = numUnobsAucTypes;
+        return( traits );
+    }
+    // Bytes allocated (or mapped) for the columns
+    size_t bytesAllocated() const {
+        return( arenaBytes );
+    }
+    // Whether the columns are mapped from a cache file rather than allocated
+    bool isMapped() const {
+        return( mappedBytes > 0 );
+    }
+
+private:
+
+    int numBidderTypes;
+    int numObsAucTypes;
+    int numUnobsAucTypes;
+    int samplesPerCell;
+    // Rows reserved per cell: samplesPerCell rounded up so that every cell starts on a cache line
+    size_t rowStride;
+
+    // The arena holding all columns, and the start of each column within it.  A mapped store's
+    // arena is the whole cache file (mappedBytes long), which is unmapped rather than freed.
+    char *arena;
+    size_t arenaBytes;
+    size_t mappedBytes;
+    double *amounts;
+    int32_t *bidderTypes;
+
+    // The store owns its arena, so it can't be copied
+    SampleBidStore(const SampleBidStore&);
+    SampleBidStore& operator=(const SampleBidStore&);
+
+    // Release the arena, however it was obtained
+    void release();
+};
+
+
+// End header guard with endif statement
+#endif
@@ -0,0 +1,116 @@
+// selection_models.hpp
+// Bid selection models as compile-time policies.  A policy says how the model reads its
+// coefficients from coeff.txt, which fields of Bid enter the utilities and how, and which kernel
+// evaluates the selection probability.  The simulation functions in bid_selection.cpp are templates
+// instantiated once per policy, so each model's arithmetic is inlined into its own copy of the hot
+// loops; simulateAuctions() and friends pick the copy from BidSelectionParams::model.
+//
+// To add a model: write a policy with the same members as the two below, add a value to
+// SelectionModel (bid_selection.hpp), and add a case for it to the switches at the end of
+// bid_selection.cpp and in calculate_costs.exe's --model option.  Fields it needs beyond those in
+// Bid are added to Bid and to the bidFields table, as before.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef SELECTION_MODELS_INCLUDED
+#define SELECTION_MODELS_INCLUDED
+
+#include "bid_selection.hpp"
+#include "nested_logit_kernel.hpp"
+
+
+// Coefficients of the competitors' utilities, already scaled by the model (so a competitor's
+// utility is amountCoeff*amount + sellRepCoeff*bidderType, with bidder types indexed from 0)
+typedef struct {
+    double amountCoeff;
+    double sellRepCoeff;
+} CompetitorCoeffs;
+
+// Utility of choosing a bid at all rather than the outside option, which depends on the buyer's
+// history.  numReps can be zero, in which case the buyer's average reputation counts as zero.
+inline double buyerNestUtility(const Bid& bid, const BidSelectionParams& params){
+    double buyRepVal = (bid.numReps > 0 ? ((double)bid.sumRep / bid.numReps) : 0);
+    return( params.nestConstant + params.lnnumrepsCoeff*log(bid.numReps + 1) + params.buyrepCoeff*buyRepVal +
+            params.lnprevcancelCoeff*log(bid.previousCancels + 1) );
+}
+
+
+// Nested logit: the bids form one nest against the outside option, with nesting parameter nestCorr.
+// coeff.txt holds c1 (bid amount), c2 (seller reputation), c3 (log number of reviews), c4 (buyer
+// reputation), c5 (log previous cancellations), c6 (constant), c7 (unused), and c8 (nestCorr).
+struct NestedLogitModel {
+
+    static void readCoefficients(const std::vector<double>& row, BidSelectionParams& params){
+        params.bidAmountCoeff = row[0];
+        params.sellRepCoeff = row[1];
+        params.lnnumrepsCoeff = row[2];
+        params.buyrepCoeff = row[3];
+        params.lnprevcancelCoeff = row[4];
+        params.nestConstant = row[5];
+        params.nestCorr = row[7];
+    }
+
+    // Utilities within the nest are divided by nestCorr
+    static inline CompetitorCoeffs competitorCoeffs(const BidSelectionParams& params){
+        double invNestCorr = 1 / params.nestCorr;
+        CompetitorCoeffs coeffs = {params.bidAmountCoeff * invNestCorr, params.sellRepCoeff * invNestCorr};
+        return( coeffs );
+    }
+
+    static inline FocalBidTerms focalTerms(const Bid& bid, const BidSelectionParams& params){
+        FocalBidTerms focal;
+        focal.nestCorr = params.nestCorr;
+        focal.invNestCorr = 1 / params.nestCorr;
+        focal.amountCoeff = params.bidAmountCoeff;
+        CompetitorCoeffs coeffs = competitorCoeffs(params);
+        focal.focalUtil = coeffs.amountCoeff*bid.amount + coeffs.sellRepCoeff*(bid.bidderType - 1);
+        focal.nestUtil = buyerNestUtility(bid, params);
+        return( focal );
+    }
+
+    static inline void evaluate(const double *utilities, const int *numOtherBids, int numSims, int maxOtherBids,
+                                const FocalBidTerms& focal, SimulationSums& sums){
+        evaluateNestedLogit(utilities, numOtherBids, numSims, maxOtherBids, focal, sums);
+    }
+};
+
+
+// Multinomial logit: every bid and the outside option are separate alternatives.  A bid's utility
+// is the buyer term plus amount and reputation terms, so the probability of bid b is
+// exp(u_b) / (1 + sum of exp(u)), the nested logit with nestCorr fixed at 1.  coeff.txt holds the
+// same c1-c6 as the nested logit; any later columns are ignored.
+struct MultinomialLogitModel {
+
+    static void readCoefficients(const std::vector<double>& row, BidSelectionParams& params){
+        params.bidAmountCoeff = row[0];
+        params.sellRepCoeff = row[1];
+        params.lnnumrepsCoeff = row[2];
+        params.buyrepCoeff = row[3];
+        params.lnprevcancelCoeff = row[4];
+        params.nestConstant = row[5];
+        params.nestCorr = 1;
+    }
+
+    static inline CompetitorCoeffs competitorCoeffs(const BidSelectionParams& params){
+        CompetitorCoeffs coeffs = {params.bidAmountCoeff, params.sellRepCoeff};
+        return( coeffs );
+    }
+
+    static inline FocalBidTerms focalTerms(const Bid& bid, const BidSelectionParams& params){
+        FocalBidTerms focal;
+        focal.nestCorr = 1;
+        focal.invNestCorr = 1;
+        focal.amountCoeff = params.bidAmountCoeff;
+        focal.focalUtil = params.bidAmountCoeff*bid.amount + params.sellRepCoeff*(bid.bidderType - 1);
+        focal.nestUtil = buyerNestUtility(bid, params);
+        return( focal );
+    }
+
+    static inline void evaluate(const double *utilities, const int *numOtherBids, int numSims, int maxOtherBids,
+                                const FocalBidTerms& focal, SimulationSums& sums){
+        evaluateMultinomialLogit(utilities, numOtherBids, numSims, maxOtherBids, focal, sums);
+    }
+};
+
+
+// End header guard with endif statement
+#endif
@@ -0,0 +1,124 @@
+// sobol_sequence.cpp
+// Building the direction numbers of the Sobol sequence declared in sobol_sequence.hpp
+
+#include "sobol_sequence.hpp"
+#include "random_streams.hpp"
+
+
+using namespace std;
+
+
+// Multiply two polynomials over GF(2) modulo poly (bit k holds the coefficient of x^k; poly has
+// degree degree)
+static uint32_t multiplyModulo(uint32_t a, uint32_t b, uint32_t poly, int degree){
+    uint32_t product = 0;
+    for(int k = degree - 1; k >= 0; k--){
+        product <<= 1;
+        if( product >> degree ){
+            product ^= poly;
+        }
+        if( (b >> k) & 1 ){
+            product ^= a;
+        }
+    }
+    return( product );
+}
+
+// x^power modulo poly
+static uint32_t powerModulo(uint64_t power, uint32_t poly, int degree){
+    uint32_t result = 1;
+    uint32_t base = (degree == 1 ? (2 ^ poly) : 2); // x, reduced when poly has degree 1
+    while( power > 0 ){
+        if( power & 1 ){
+            result = multiplyModulo(result, base, poly, degree);
+        }
+        base = multiplyModulo(base, base, poly, degree);
+        power >>= 1;
+    }
+    return( result );
+}
+
+// A polynomial of degree d is primitive when x has order exactly 2^d - 1 modulo it: x^(2^d - 1) = 1
+// but x^((2^d - 1)/p) != 1 for every prime p dividing 2^d - 1
+static bool isPrimitive(uint32_t poly, int degree){
+
+    uint64_t order = ((uint64_t)1 << degree) - 1;
+    if( powerModulo(order, poly, degree) != 1 ){
+        return( false );
+    }
+    uint64_t remaining = order;
+    for(uint64_t p = 2; p*p <= remaining; p++){
+        if( remaining % p == 0 ){
+            if( powerModulo(order / p, poly, degree) == 1 ){
+                return( false );
+            }
+            while( remaining % p == 0 ){
+                remaining /= p;
+            }
+        }
+    }
+    if( (remaining > 1) && (remaining < order) && (powerModulo(order / remaining, poly, degree) == 1) ){
+        return( false );
+    }
+    return( true );
+}
+
+
+// Build the direction numbers
+SobolSequence::SobolSequence(int numDims){
+
+    directions.assign(32*numDims, 0);
+
+    // Dimension 0: v_k = 2^(31 - k)
+    if( numDims > 0 ){
+        for(int bit = 0; bit < 32; bit++){
+            directions[bit] = (uint32_t)1 << (31 - bit);
+        }
+    }
+
+    // Fixed stream for the initial direction numbers
+    RandomStream initialDraws(0x50B01, 0, 0, 0);
+
+    int degree = 1;
+    uint32_t poly = (1 << degree) | 1;
+    for(int dim = 1; dim < numDims; dim++){
+
+        // Next primitive polynomial: x^degree + ... + 1
+        while( !isPrimitive(poly, degree) ){
+            poly += 2;
+            if( poly >> (degree + 1) ){
+                degree++;
+                poly = ((uint32_t)1 << degree) | 1;
+            }
+        }
+
+        // Initial direction numbers m_1, ..., m_degree: odd, with m_k < 2^k
+        uint32_t *v = directions.data() + 32*dim;
+        vector<uint32_t> m(32);
+        for(int k = 0; k < degree && k < 32; k++){
+            m[k] = 2*initialDraws.nextIndex(1 << k) + 1;
+        }
+        // Later numbers follow the recurrence of the polynomial's coefficients a_1, ..., a_(degree - 1):
+        // m_k = 2 a_1 m_(k-1) ^ 4 a_2 m_(k-2) ^ ... ^ 2^degree m_(k-degree) ^ m_(k-degree)
+        for(int k = degree; k < 32; k++){
+            uint32_t next = m[k - degree] ^ (m[k - degree] << degree);
+            for(int j = 1; j < degree; j++){
+                if( (poly >> (degree - j)) & 1 ){
+                    next ^= m[k - j] << j;
+                }
+            }
+            m[k] = next;
+        }
+        // v_k = m_k / 2^(k + 1) as a 32-bit fraction
+        for(int bit = 0; bit < 32; bit++){
+            v[bit] = m[bit] << (31 - bit);
+        }
+
+        // Move past this polynomial for the next dimension
+        poly += 2;
+        if( poly >> (degree + 1) ){
+            degree++;
+            poly = ((uint32_t)1 << degree) | 1;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+// sobol_sequence.hpp
+// Sobol low-discrepancy sequence for quasi-Monte Carlo simulation of auctions
+// Point i of the sequence fills the uniforms of simulated auction i, one dimension per draw (the
+// number of other bids, then each competitor's bidder type and sample row).  Each stream of
+// simulations scrambles the points with its own random digital shift, which keeps every uniform
+// exactly uniform on [0, 1) while preserving the even spread of the points, so averages stay
+// unbiased and independent streams give honest error estimates.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef SOBOL_SEQUENCE_INCLUDED
+#define SOBOL_SEQUENCE_INCLUDED
+
+#include <vector>
+#include <stdint.h>
+
+
+class SobolSequence {
+
+public:
+
+    // Build direction numbers for numDims dimensions.  Dimension 0 is the van der Corput sequence;
+    // dimension d > 0 uses the d-th primitive polynomial over GF(2), in order of degree, with odd
+    // initial direction numbers drawn from a fixed stream so that the sequence never changes.
+    SobolSequence(int numDims);
+
+    // Coordinate dim of point index as a 32-bit fraction: the XOR of the direction numbers for the
+    // set bits of index.  Defined here so that it is inlined into the draw loop.
+    uint32_t point(uint32_t index, int dim) const {
+        const uint32_t *v = directions.data() + 32*dim;
+        uint32_t x = 0;
+        for(int bit = 0; index != 0; bit++, index >>= 1){
+            if( index & 1 ){
+                x ^= v[bit];
+            }
+        }
+        return( x );
+    }
+
+    // Number of dimensions
+    int numDims() const {
+        return( directions.size() / 32 );
+    }
+
+private:
+
+    // Direction numbers: directions[32*dim + bit] for bit = 0, ..., 31
+    std::vector<uint32_t> directions;
+};
+
+
+// End header guard with endif statement
+#endif
@@ -0,0 +1,231 @@
+// synthetic_data.cpp
+// Writing the synthetic input files declared in synthetic_data.hpp
+
+// Libraries imported in bid_selection.hpp
+#include "bid_selection.hpp"
+#include "synthetic_data.hpp"
+#include "import_data.hpp"
+
+// Use standard namespace: can call cout and vector rather than std::cout and std::vector
+using namespace std;
+
+
+// Stream types of the random draws, so that each file reads its own streams
+static const uint32_t distributionStream = 0;
+static const uint32_t sampleBidStream = 1;
+static const uint32_t auctionStream = 2;
+
+// Buffer size for the files; the bid file is written in blocks of this size as it is generated
+static const size_t writeBufferBytes = 1 << 20;
+
+
+// Open a file for writing with a large buffer (NULL, after printing an error, if it can't be opened)
+static FILE *openOutput(const char *fileName){
+    FILE *outFile = fopen(fileName, "w");
+    if( outFile == NULL ){
+        cout << "Error: could not write " << fileName << ".\n";
+        return( NULL );
+    }
+    setvbuf(outFile, NULL, _IOFBF, writeBufferBytes);
+    return( outFile );
+}
+
+// Close a file, adding its size to bytesWritten.  Returns false (after printing an error) if any
+// write to it failed.
+static bool closeOutput(FILE *outFile, const char *fileName, size_t& bytesWritten){
+    bytesWritten += ftell(outFile);
+    bool failed = (ferror(outFile) != 0);
+    failed |= (fclose(outFile) != 0);
+    if( failed ){
+        cout << "Error: could not finish writing " << fileName << ".\n";
+    }
+    return( !failed );
+}
+
+// Draw a bid amount for a bidder type, observed auction type, and unobserved auction type (all
+// indexed from 0).  Bids are uniform on +/- 25% around a level that rises with every type, so that
+// the types are distinguishable in the sample bids.
+static double drawAmount(int bidderType, int obsAucType, int uAucType, RandomStream& draws){
+    double level = 100 * (1 + 0.25*bidderType + 0.1*obsAucType + 0.3*uAucType);
+    return( level * (0.75 + 0.5*draws.nextUniform()) );
+}
+
+// Random probabilities for numValues outcomes in each of numRows rows, each weight drawn from
+// [0.5, 1.5) before normalizing so that no outcome is rare
+static vector< vector<double> > drawDistribution(int numRows, int numValues, RandomStream& draws){
+    vector< vector<double> > probs(numRows, vector<double>(numValues));
+    for(int row = 0; row < numRows; row++){
+        double total = 0;
+        for(int col = 0; col < numValues; col++){
+            probs[row][col] = 0.5 + draws.nextUniform();
+            total += probs[row][col];
+        }
+        for(int col = 0; col < numValues; col++){
+            probs[row][col] /= total;
+        }
+    }
+    return( probs );
+}
+
+// Write a distribution with one row per observed auction type, as import_data.cpp reads it
+static bool writeDistribution(const char *fileName, const vector< vector<double> >& probs, size_t& bytesWritten){
+    FILE *outFile = openOutput(fileName);
+    if( outFile == NULL ){
+        return( false );
+    }
+    for(size_t row = 0; row < probs.size(); row++){
+        for(size_t col = 0; col < probs[row].size(); col++){
+            fprintf(outFile, "%.10g%s", probs[row][col], (col + 1 < probs[row].size()) ? "," : "\n");
+        }
+    }
+    return( closeOutput(outFile, fileName, bytesWritten) );
+}
+
+
+// Write all input files
+bool writeSyntheticData(const SyntheticDataParams& params, size_t& bytesWritten){
+
+    AucTraits aucTraits = params.aucTraits;
+    bytesWritten = 0;
+    char fileName[100];
+
+    //// Distributions of the number of other bids (1 to maxAuctionSize - 1) and bidder types
+    RandomStream distributionDraws(params.seed, 0, distributionStream, 0);
+    vector< vector<double> > numBidProbs = drawDistribution(aucTraits.numObsAucTypes, params.maxAuctionSize - 1,
+                                                            distributionDraws);
+    vector< vector<double> > bidderTypeProbs = drawDistribution(aucTraits.numObsAucTypes, aucTraits.numBidderTypes,
+                                                                distributionDraws);
+    if( !writeDistribution("num_bid_distribution.csv", numBidProbs, bytesWritten) ||
+        !writeDistribution("bidder_type_distribution.csv", bidderTypeProbs, bytesWritten) ){
+        return( false );
+    }
+
+    //// Coefficients, in the order estimate_bid_selection.do writes them (c7 isn't used)
+    FILE *coeffFile = openOutput("coeff.txt");
+    if( coeffFile == NULL ){
+        return( false );
+    }
+    const BidSelectionParams& coeffs = params.coeffs;
+    fprintf(coeffFile, "\tc1\tc2\tc3\tc4\tc5\tc6\tc7\tc8\n");
+    fprintf(coeffFile, "y1\t%.10g\t%.10g\t%.10g\t%.10g\t%.10g\t%.10g\t1\t%.10g\n", coeffs.bidAmountCoeff,
+            coeffs.sellRepCoeff, coeffs.lnnumrepsCoeff, coeffs.buyrepCoeff, coeffs.lnprevcancelCoeff,
+            coeffs.nestConstant, coeffs.nestCorr);
+    if( !closeOutput(coeffFile, "coeff.txt", bytesWritten) ){
+        return( false );
+    }
+
+    //// Sample bids: draws from the bid distribution of each type cell
+    for(int i = 0; i < aucTraits.numBidderTypes; i++){
+        for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+            for(int k = 0; k < aucTraits.numUnobsAucTypes; k++){
+                sprintf(fileName, "sample_bids_btype_%d_oauctype_%d_uauctype_%d.csv", i + 1, j + 1, k + 1);
+                FILE *sampleBidFile = openOutput(fileName);
+                if( sampleBidFile == NULL ){
+                    return( false );
+                }
+                int cell = (i*aucTraits.numObsAucTypes + j)*aucTraits.numUnobsAucTypes + k;
+                RandomStream draws(params.seed, cell, sampleBidStream, 0);
+                fprintf(sampleBidFile, "BidAmount, BidderType\n");
+                for(int row = 0; row < params.numSamples; row++){
+                    fprintf(sampleBidFile, "%.4f, %d\n", drawAmount(i, j, k, draws), i + 1);
+                }
+                if( !closeOutput(sampleBidFile, fileName, bytesWritten) ){
+                    return( false );
+                }
+            }
+        }
+    }
+
+    // Manifest of the sample bid files, as convert_sample_bids.exe --write-manifest would write it
+    if( !writeSampleBidManifest(sampleBidManifestFile, aucTraits, 1) ){
+        return( false );
+    }
+
+    //// Bids, one auction at a time
+    // Each auction draws from its own stream: its observed and unobserved types, the buyer's
+    // history, the number of bids and each bid's type and amount, then the procurer's choice
+    vector<AliasTable> numBidTables;
+    vector<AliasTable> bidderTypeTables;
+    for(int j = 0; j < aucTraits.numObsAucTypes; j++){
+        numBidTables.push_back( AliasTable(numBidProbs[j]) );
+        bidderTypeTables.push_back( AliasTable(bidderTypeProbs[j]) );
+    }
+    FILE *bidFile = openOutput("template_data.csv");
+    if( bidFile == NULL ){
+        return( false );
+    }
+    fprintf(bidFile, "AuctionID, BidderType, OAucType, BidAmount, Decision, OverallDecision, SumRep, "
+                     "NumReps, PreviousAuctions, PreviousCancels, Other\n");
+
+    vector<Bid> auctionBids(params.maxAuctionSize);
+    vector<double> utilities(params.maxAuctionSize);
+    long long auctionID = 0;
+    for(long long bidsWritten = 0; bidsWritten < params.numBids; ){
+
+        auctionID++;
+        RandomStream draws(params.seed, auctionID, auctionStream, 0);
+        Bid outsideOption;
+        outsideOption.amount = 0;
+        outsideOption.bidderType = 0;
+        outsideOption.obsAucType = draws.nextIndex(aucTraits.numObsAucTypes) + 1;
+        int uAucType = draws.nextIndex(aucTraits.numUnobsAucTypes);
+        outsideOption.numReps = draws.nextIndex(5) + 1;
+        outsideOption.sumRep = draws.nextIndex(5*outsideOption.numReps + 1);
+        outsideOption.previousAuctions = draws.nextIndex(20);
+        outsideOption.previousCancels = draws.nextIndex(4);
+
+        // The last auction is cut short so that exactly numBids bids are written
+        int j = outsideOption.obsAucType - 1;
+        int numAucBids = numBidTables[j].draw( draws.nextUniform() ) + 2;
+        numAucBids = (int)min((long long)numAucBids, params.numBids - bidsWritten);
+
+        // Utilities within the nest of bids, divided by nestCorr as in simulateAuctions(), and
+        // the inclusive value of the nest
+        double maxUtil = -HUGE_VAL;
+        for(int b = 0; b < numAucBids; b++){
+            auctionBids[b] = outsideOption;
+            auctionBids[b].bidderType = bidderTypeTables[j].draw( draws.nextUniform() ) + 1;
+            auctionBids[b].amount = drawAmount(auctionBids[b].bidderType - 1, j, uAucType, draws);
+            utilities[b] = (coeffs.bidAmountCoeff*auctionBids[b].amount +
+                            coeffs.sellRepCoeff*(auctionBids[b].bidderType - 1)) / coeffs.nestCorr;
+            maxUtil = max(maxUtil, utilities[b]);
+        }
+        double expSum = 0;
+        for(int b = 0; b < numAucBids; b++){
+            expSum += exp(utilities[b] - maxUtil);
+        }
+        double incVal = maxUtil + log(expSum);
+
+        // The procurer picks the nest of bids with logistic probability, then a bid within it
+        double buyRepVal = (double)outsideOption.sumRep / outsideOption.numReps;
+        double nestUtil = coeffs.nestConstant + coeffs.lnnumrepsCoeff*log(outsideOption.numReps + 1) +
+            coeffs.buyrepCoeff*buyRepVal + coeffs.lnprevcancelCoeff*log(outsideOption.previousCancels + 1);
+        bool choseBid = draws.nextUniform() < 1 / (1 + exp(-(nestUtil + coeffs.nestCorr*incVal)));
+        int winner = -1;
+        if( choseBid ){
+            double u = draws.nextUniform() * expSum;
+            winner = numAucBids - 1;
+            for(int b = 0; b < numAucBids - 1; b++){
+                u -= exp(utilities[b] - maxUtil);
+                if( u < 0 ){
+                    winner = b;
+                    break;
+                }
+            }
+        }
+
+        // Write the outside option row, then the bids
+        fprintf(bidFile, "%lld, 0, %d, 0, %d, %d, %d, %d, %d, %d, 0\n", auctionID, outsideOption.obsAucType,
+                choseBid ? 0 : 1, choseBid ? 1 : 0, outsideOption.sumRep, outsideOption.numReps,
+                outsideOption.previousAuctions, outsideOption.previousCancels);
+        for(int b = 0; b < numAucBids; b++){
+            const Bid& bid = auctionBids[b];
+            fprintf(bidFile, "%lld, %d, %d, %.2f, %d, %d, %d, %d, %d, %d, 0\n", auctionID, bid.bidderType,
+                    bid.obsAucType, bid.amount, (b == winner) ? 1 : 0, choseBid ? 1 : 0, bid.sumRep, bid.numReps,
+                    bid.previousAuctions, bid.previousCancels);
+        }
+        bidsWritten += numAucBids;
+    }
+
+    return( closeOutput(bidFile, "template_data.csv", bytesWritten) );
+}
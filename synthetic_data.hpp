@@ -0,0 +1,35 @@
+// synthetic_data.hpp
+// Generating a complete, consistent set of inputs for calculate_costs.exe from a few parameters:
+// the bids (template_data.csv), the sample bids of every type cell and their manifest, the
+// selection model coefficients (coeff.txt), and the distributions of the number of bids and bidder
+// types.  The bids are drawn from the same distributions that the other files describe, and the
+// winner of each auction from the nested logit with the given coefficients, so the files fit
+// together as if they came from the earlier stages of the estimation.  Used by
+// generate_synthetic_data.cpp and benchmark_estimation.cpp.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef SYNTHETIC_DATA_INCLUDED
+#define SYNTHETIC_DATA_INCLUDED
+
+#include <stdint.h>
+#include "bid_selection.hpp"
+
+
+// Parameters of a synthetic data set
+typedef struct {
+    uint64_t seed;              // seed for every random draw; the same parameters give the same files
+    long long numBids;          // bids in template_data.csv, not counting the outside option rows
+    AucTraits aucTraits;        // numbers of bidder types and observed and unobserved auction types
+    int maxAuctionSize;         // largest number of bids in an auction (at least 2)
+    int numSamples;             // rows of each sample bid file
+    BidSelectionParams coeffs;  // selection model coefficients, written to coeff.txt
+} SyntheticDataParams;
+
+// Write all input files to the current directory.  The bids are written as they are drawn, so
+// memory use doesn't grow with numBids.  Returns false (after printing an error) if a file can't
+// be written; bytesWritten is set to the total size of the files.
+bool writeSyntheticData(const SyntheticDataParams& params, size_t& bytesWritten);
+
+
+// End header guard with endif statement
+#endif
@@ -0,0 +1,162 @@
+// weighted_kde.cpp
+// Implementing the binned kernel density estimates declared in weighted_kde.hpp
+
+#include "weighted_kde.hpp"
+#include <math.h>
+#include <algorithm>
+
+
+using namespace std;
+
+
+// The kernel is cut off this many bandwidths from its center, where its weight is below exp(-50)
+// of the peak; the grid extends this far beyond the points
+static const double kernelReach = 10;
+
+
+WeightedKde::WeightedKde(const KdeSettings& kdeSettings, const vector<double>& densityPoints, int numDensities){
+
+    settings = kdeSettings;
+    settings.numBins = max(settings.numBins, 2);
+    points = densityPoints;
+    numWeights = numDensities;
+    bins.assign((size_t)numWeights*settings.numBins, 0);
+    totals.assign(numWeights, 0);
+
+    // Cover the log-odds of the points inside the support
+    double first = HUGE_VAL;
+    double last = -HUGE_VAL;
+    for(size_t j = 0; j < points.size(); j++){
+        if( (points[j] > settings.lower) && (points[j] < settings.upper) ){
+            first = min(first, logOdds(points[j]));
+            last = max(last, logOdds(points[j]));
+        }
+    }
+    if( first > last ){
+        first = 0;
+        last = 0;
+    }
+    gridStart = first - kernelReach*settings.bandwidth;
+    gridStep = (last - first + 2*kernelReach*settings.bandwidth) / (settings.numBins - 1);
+}
+
+
+double WeightedKde::logOdds(double x) const {
+    return( log(x - settings.lower) - log(settings.upper - x) );
+}
+
+
+void WeightedKde::add(double x, const double *weights){
+
+    if( (x <= settings.lower) || (x >= settings.upper) ){
+        return;
+    }
+    for(int k = 0; k < numWeights; k++){
+        totals[k] += weights[k];
+    }
+
+    // Linear binning: split the weight between the two nodes around the sample, in proportion to
+    // how close it is to each
+    double position = (logOdds(x) - gridStart) / gridStep;
+    if( (position < 0) || (position >= settings.numBins - 1) ){
+        return;
+    }
+    int node = (int)position;
+    double upperShare = position - node;
+    for(int k = 0; k < numWeights; k++){
+        bins[(size_t)k*settings.numBins + node] += weights[k]*(1 - upperShare);
+        bins[(size_t)k*settings.numBins + node + 1] += weights[k]*upperShare;
+    }
+}
+
+
+void WeightedKde::densities(vector<double>& densities) const {
+
+    int numBins = settings.numBins;
+    double h = settings.bandwidth;
+    densities.assign(numWeights*points.size(), settings.lowProb);
+
+    // Kernel weights at offsets of up to reach nodes.  The transforms are padded to at least
+    // numBins + reach so that the circular convolution doesn't wrap the far end of the grid onto
+    // the near end.
+    int reach = (int)ceil(kernelReach*h / gridStep);
+    size_t fftSize = 1;
+    while( fftSize < (size_t)(numBins + reach) ){
+        fftSize *= 2;
+    }
+    vector< complex<double> > kernel(fftSize, 0.0);
+    for(int j = 0; j <= reach; j++){
+        double z = j*gridStep / h;
+        kernel[j] = exp(-0.5*z*z);
+        if( j > 0 ){
+            kernel[fftSize - j] = kernel[j];
+        }
+    }
+    fft(kernel, false);
+
+    vector< complex<double> > grid(fftSize);
+    for(int k = 0; k < numWeights; k++){
+        if( !(totals[k] > 0) ){
+            continue;
+        }
+
+        // Smooth the binned weights
+        fill(grid.begin(), grid.end(), 0.0);
+        for(int i = 0; i < numBins; i++){
+            grid[i] = bins[(size_t)k*numBins + i];
+        }
+        fft(grid, false);
+        for(size_t i = 0; i < fftSize; i++){
+            grid[i] *= kernel[i];
+        }
+        fft(grid, true);
+
+        // Interpolate each point from the nodes around it, normalize, and transform back to the
+        // original scale
+        double scale = 1 / (fftSize * totals[k] * h * sqrt(2*M_PI));
+        for(size_t j = 0; j < points.size(); j++){
+            if( (points[j] <= settings.lower) || (points[j] >= settings.upper) ){
+                continue;
+            }
+            double position = (logOdds(points[j]) - gridStart) / gridStep;
+            int node = min(max((int)position, 0), numBins - 2);
+            double upperShare = position - node;
+            double smoothed = (1 - upperShare)*grid[node].real() + upperShare*grid[node + 1].real();
+            double jacobian = 1 / (points[j] - settings.lower) + 1 / (settings.upper - points[j]);
+            densities[k*points.size() + j] = max(smoothed*scale*jacobian, settings.lowProb);
+        }
+    }
+}
+
+
+void fft(vector< complex<double> >& values, bool inverse){
+
+    size_t n = values.size();
+
+    // Put the values in bit-reversed order
+    for(size_t i = 1, j = 0; i < n; i++){
+        size_t bit = n >> 1;
+        for( ; j & bit; bit >>= 1){
+            j ^= bit;
+        }
+        j ^= bit;
+        if( i < j ){
+            swap(values[i], values[j]);
+        }
+    }
+
+    // Combine transforms of length half into transforms of length 2*half, computing each twiddle
+    // factor once per stage
+    double sign = (inverse ? 1 : -1);
+    for(size_t half = 1; half < n; half *= 2){
+        for(size_t j = 0; j < half; j++){
+            complex<double> twiddle = polar(1.0, sign*M_PI*j/half);
+            for(size_t start = 0; start < n; start += 2*half){
+                complex<double> even = values[start + j];
+                complex<double> odd = values[start + j + half]*twiddle;
+                values[start + j] = even + odd;
+                values[start + j + half] = even - odd;
+            }
+        }
+    }
+}
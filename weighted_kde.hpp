@@ -0,0 +1,67 @@
+// weighted_kde.hpp
+// Weighted kernel density estimates on a bounded support, as ksdensity(x, points, 'support',
+// [lower, upper], 'width', bandwidth, 'weights', w) computes them, for several weight vectors at
+// once.  As in ksdensity, each sample is moved to the log-odds scale log((x - lower)/(upper - x)),
+// a Gaussian kernel density is estimated there, and the density is transformed back.  Instead of
+// summing a kernel for every (sample, point) pair, the samples are spread linearly over the two
+// nearest nodes of a uniform grid on the log-odds scale, the grid is convolved with the kernel by
+// FFT, and each point is interpolated from the smoothed grid.  A density costs O(n + G log G) for
+// n samples and G grid nodes, and the samples are binned once for all the weight vectors.
+
+// Header guards: make sure that the header isn't loaded twice
+#ifndef WEIGHTED_KDE_INCLUDED
+#define WEIGHTED_KDE_INCLUDED
+
+#include <vector>
+#include <complex>
+
+
+// Settings of the estimate
+typedef struct {
+    double lower;       // support: densities are zero at and outside lower and upper
+    double upper;
+    double bandwidth;   // standard deviation of the kernel on the log-odds scale
+    double lowProb;     // floor on each density at a point inside the support
+    int numBins;        // nodes of the grid on the log-odds scale
+} KdeSettings;
+
+class WeightedKde {
+
+public:
+
+    // Prepare to estimate numWeights densities at points.  The grid covers the points inside the
+    // support, widened by the reach of the kernel on both sides.
+    WeightedKde(const KdeSettings& kdeSettings, const std::vector<double>& points, int numWeights);
+
+    // Add a sample with weights[k] in density k.  Samples outside the support are ignored, and
+    // samples beyond the reach of the kernel from every point count only toward the total weight.
+    void add(double x, const double *weights);
+
+    // Densities at the points, normalized by each weight vector's total as ksdensity does, with
+    // density k at point j in densities[k*numPoints + j].  Densities with no weight are lowProb.
+    void densities(std::vector<double>& densities) const;
+
+private:
+
+    KdeSettings settings;
+    std::vector<double> points;
+    int numWeights;
+
+    // Grid node i is at gridStart + i*gridStep on the log-odds scale; bins[k*numBins + i] is the
+    // weight of density k at node i, and totals[k] the total weight of density k
+    double gridStart;
+    double gridStep;
+    std::vector<double> bins;
+    std::vector<double> totals;
+
+    // Log-odds of a value inside the support
+    double logOdds(double x) const;
+};
+
+// In-place radix-2 FFT of values (whose size is a power of two); inverse gives the unscaled
+// inverse transform
+void fft(std::vector< std::complex<double> >& values, bool inverse);
+
+
+// End header guard with endif statement
+#endif